@@ -0,0 +1,62 @@
+#ifndef _ACCEPTOR_H_
+#define _ACCEPTOR_H_
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <span>
+#include <string_view>
+
+#include "framing.h"
+#include "reactor.h"
+#include "shard.h"
+
+// Accepts connections, waits for their JOIN frame and hands them to the
+// shard that owns the room. The listening socket is edge-triggered and
+// drained with accept4 on every wake-up, so a burst of connects is taken
+// in one go. With SO_REUSEPORT several acceptors, each on its own thread
+// with its own listening socket, share the port and the kernel spreads
+// incoming connections over them.
+//
+// A connection gets kJoinTimeout to send its JOIN, and at most
+// kMaxPending may be waiting at once; past that new connections are
+// refused, so clients that connect and stay silent cannot pile up.
+class Acceptor {
+ public:
+  static constexpr std::chrono::seconds kJoinTimeout{5};
+  static constexpr std::size_t kMaxPending = 4096;
+
+  explicit Acceptor(std::span<const std::unique_ptr<Shard>> shards);
+  ~Acceptor();
+
+  Acceptor(const Acceptor&) = delete;
+  Acceptor& operator=(const Acceptor&) = delete;
+
+  // `reusePort` lets other acceptors listen on the same port.
+  bool listen(unsigned short port, bool reusePort);
+
+  // Runs the accept loop on the calling thread; never returns.
+  void run();
+
+ private:
+  void acceptClients();
+  void receiveFrom(int socket);
+  void handOff(int socket, std::string_view payload);
+  void dropPending(int socket);
+  // Closes the connections that have been waiting longer than kJoinTimeout.
+  void dropExpired();
+
+  std::span<const std::unique_ptr<Shard>> shards_;
+  Reactor reactor_;
+  int listener_ = -1;
+  // Connections that have not sent JOIN yet.
+  struct Pending {
+    std::unique_ptr<FrameBuffer> buffer;
+    std::chrono::steady_clock::time_point accepted;
+  };
+  std::map<int, Pending> pending_;
+  std::chrono::steady_clock::time_point nextSweep_;
+};
+
+#endif //_ACCEPTOR_H_
@@ -0,0 +1,82 @@
+#ifndef _ATTACKS_H_
+#define _ATTACKS_H_
+
+#include <array>
+#include <cstdint>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#include "bitboard.h"
+#include "types.h"
+
+// Per-square attack lookups. Knight, king and pawn tables are generated at
+// compile time; rook and bishop attacks come from "fancy" magic bitboard
+// tables built once at startup (or indexed with PEXT when compiled for
+// BMI2), so every attack query is a single table load.
+
+namespace attacks_detail {
+
+template <typename Generate>
+constexpr std::array<Bitboard, 64> makeTable(Generate generate) {
+  std::array<Bitboard, 64> table{};
+  for (Square square = 0; square < 64; ++square)
+    table[square] = generate(squareBit(square));
+  return table;
+}
+
+struct Magic {
+  Bitboard mask;
+  Bitboard magic;
+  const Bitboard* attacks;
+  unsigned shift;
+
+  std::size_t index(Bitboard occupied) const {
+#if defined(__BMI2__)
+    return _pext_u64(occupied, mask);
+#else
+    return static_cast<std::size_t>(((occupied & mask) * magic) >> shift);
+#endif
+  }
+};
+
+extern std::array<Magic, 64> ROOK_MAGICS;
+extern std::array<Magic, 64> BISHOP_MAGICS;
+extern std::array<std::array<Bitboard, 64>, 64> BETWEEN;
+extern std::array<std::array<Bitboard, 64>, 64> LINE;
+
+}  // namespace attacks_detail
+
+inline constexpr std::array<Bitboard, 64> KNIGHT_ATTACKS = attacks_detail::makeTable(knightAttackSet);
+inline constexpr std::array<Bitboard, 64> KING_ATTACKS = attacks_detail::makeTable(kingAttackSet);
+inline constexpr std::array<std::array<Bitboard, 64>, 2> PAWN_ATTACKS = {
+    attacks_detail::makeTable([](Bitboard bit) { return pawnAttackSet(Color::kWhite, bit); }),
+    attacks_detail::makeTable([](Bitboard bit) { return pawnAttackSet(Color::kBlack, bit); })};
+
+inline Bitboard knightAttacks(Square square) { return KNIGHT_ATTACKS[square]; }
+inline Bitboard kingAttacks(Square square) { return KING_ATTACKS[square]; }
+inline Bitboard pawnAttacks(Color color, Square square) {
+  return PAWN_ATTACKS[static_cast<int>(color)][square];
+}
+
+inline Bitboard rookAttacks(Square square, Bitboard occupied) {
+  const attacks_detail::Magic& magic = attacks_detail::ROOK_MAGICS[square];
+  return magic.attacks[magic.index(occupied)];
+}
+
+inline Bitboard bishopAttacks(Square square, Bitboard occupied) {
+  const attacks_detail::Magic& magic = attacks_detail::BISHOP_MAGICS[square];
+  return magic.attacks[magic.index(occupied)];
+}
+
+inline Bitboard queenAttacks(Square square, Bitboard occupied) {
+  return rookAttacks(square, occupied) | bishopAttacks(square, occupied);
+}
+
+// Squares strictly between two aligned squares (empty if not aligned).
+inline Bitboard between(Square a, Square b) { return attacks_detail::BETWEEN[a][b]; }
+// The whole rank, file or diagonal through two aligned squares.
+inline Bitboard line(Square a, Square b) { return attacks_detail::LINE[a][b]; }
+
+#endif //_ATTACKS_H_
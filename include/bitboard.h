@@ -0,0 +1,92 @@
+#ifndef _BITBOARD_H_
+#define _BITBOARD_H_
+
+#include <bit>
+#include <cstdint>
+
+#include "types.h"
+
+using Bitboard = std::uint64_t;
+
+static constexpr Bitboard FILE_A = 0x0101010101010101ull;
+static constexpr Bitboard FILE_H = FILE_A << 7;
+static constexpr Bitboard RANK_1 = 0xFFull;
+static constexpr Bitboard RANK_2 = RANK_1 << 8;
+static constexpr Bitboard RANK_4 = RANK_1 << 24;
+static constexpr Bitboard RANK_5 = RANK_1 << 32;
+static constexpr Bitboard RANK_7 = RANK_1 << 48;
+static constexpr Bitboard RANK_8 = RANK_1 << 56;
+
+constexpr Bitboard squareBit(Square square) { return 1ull << square; }
+
+inline int popCount(Bitboard bits) { return std::popcount(bits); }
+inline Square lsb(Bitboard bits) { return std::countr_zero(bits); }
+inline Square popLsb(Bitboard& bits) {
+  const Square square = lsb(bits);
+  bits &= bits - 1;
+  return square;
+}
+
+constexpr Bitboard north(Bitboard bits) { return bits << 8; }
+constexpr Bitboard south(Bitboard bits) { return bits >> 8; }
+constexpr Bitboard east(Bitboard bits) { return (bits & ~FILE_H) << 1; }
+constexpr Bitboard west(Bitboard bits) { return (bits & ~FILE_A) >> 1; }
+
+constexpr Bitboard pawnPush(Color color, Bitboard bits) {
+  return color == Color::kWhite ? north(bits) : south(bits);
+}
+
+// Set-wise attacks: the union of the attacks of every piece in `bits`.
+// Per-square lookups live in attacks.h.
+constexpr Bitboard pawnAttackSet(Color color, Bitboard bits) {
+  const Bitboard forward = pawnPush(color, bits);
+  return east(forward) | west(forward);
+}
+
+constexpr Bitboard knightAttackSet(Bitboard bits) {
+  const Bitboard oneFile = east(bits) | west(bits);
+  const Bitboard twoFiles = east(east(bits)) | west(west(bits));
+  return (oneFile << 16) | (oneFile >> 16) | (twoFiles << 8) | (twoFiles >> 8);
+}
+
+constexpr Bitboard kingAttackSet(Bitboard bits) {
+  const Bitboard sideways = east(bits) | west(bits);
+  const Bitboard row = bits | sideways;
+  return sideways | north(row) | south(row);
+}
+
+namespace bitboard_detail {
+constexpr Bitboard shift(Bitboard bits, int amount) {
+  return amount > 0 ? bits << amount : bits >> -amount;
+}
+
+// Kogge-Stone occluded fill: floods `generators` along one direction
+// through empty squares in three shifts, then steps once more to include
+// the blocker. `guard` removes the squares a step would wrap onto.
+constexpr Bitboard ray(Bitboard generators, Bitboard empty, int step, Bitboard guard) {
+  empty &= guard;
+  generators |= empty & shift(generators, step);
+  empty &= shift(empty, step);
+  generators |= empty & shift(generators, 2 * step);
+  empty &= shift(empty, 2 * step);
+  generators |= empty & shift(generators, 4 * step);
+  return shift(generators, step) & guard;
+}
+}  // namespace bitboard_detail
+
+constexpr Bitboard rookAttackSet(Bitboard from, Bitboard occupied) {
+  using bitboard_detail::ray;
+  const Bitboard empty = ~occupied;
+  return ray(from, empty, 8, ~0ull) | ray(from, empty, -8, ~0ull) | ray(from, empty, 1, ~FILE_A) |
+         ray(from, empty, -1, ~FILE_H);
+}
+
+constexpr Bitboard bishopAttackSet(Bitboard from, Bitboard occupied) {
+  using bitboard_detail::ray;
+  const Bitboard empty = ~occupied;
+  return ray(from, empty, 9, ~FILE_A) | ray(from, empty, 7, ~FILE_H) | ray(from, empty, -7, ~FILE_A) |
+         ray(from, empty, -9, ~FILE_H);
+}
+
+
+#endif //_BITBOARD_H_
@@ -0,0 +1,55 @@
+#ifndef _BOOK_H_
+#define _BOOK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "position.h"
+#include "zobrist.h"
+
+// Opening book: a file of 16 byte Polyglot-style records (big-endian key,
+// move, weight, learn), sorted by key, keyed by this engine's Zobrist
+// keys. The file is memory-mapped read-only, so every thread and every
+// server process on the machine shares one copy through the page cache,
+// and a lookup is a binary search with no allocation.
+
+static constexpr std::size_t BOOK_RECORD_SIZE = 16;
+
+struct BookMove {
+  Move move;
+  std::uint16_t weight = 0;
+};
+
+// Polyglot move encoding: to square (6) | from square (6) | promotion (3),
+// with castling written as the king taking its own rook.
+std::uint16_t toBookMove(Move move);
+
+class OpeningBook {
+ public:
+  OpeningBook() = default;
+  ~OpeningBook();
+
+  OpeningBook(const OpeningBook&) = delete;
+  OpeningBook& operator=(const OpeningBook&) = delete;
+
+  bool open(const char* path);
+  bool isOpen() const { return records_ != nullptr; }
+  std::size_t size() const { return count_; }
+
+  // Legal book moves for the position, heaviest first; at most
+  // moves.size() of them. Returns how many were written.
+  std::size_t probe(const Position& position, std::span<BookMove> moves) const;
+
+  // A book move chosen with probability proportional to its weight;
+  // `random` is any 64 bit random number. Null when out of book.
+  Move pick(const Position& position, std::uint64_t random) const;
+
+ private:
+  Key keyAt(std::size_t index) const;
+
+  const unsigned char* records_ = nullptr;
+  std::size_t count_ = 0;
+};
+
+#endif //_BOOK_H_
@@ -0,0 +1,75 @@
+#ifndef _BOT_ENGINE_H_
+#define _BOT_ENGINE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "book.h"
+#include "compute_pool.h"
+#include "position.h"
+#include "room.h"
+#include "search.h"
+#include "search_pool.h"
+#include "tt.h"
+
+struct BotOptions {
+  SearchLimits limits;
+  std::size_t hashMegabytes = 16;
+  // With a shared table, what the engine learnt in one room helps in every
+  // other room; otherwise each compute thread has a table of its own whose
+  // entries are retired whenever it moves on to another room.
+  bool shareHash = true;
+  // Lazy SMP threads per bot search, the compute thread included.
+  std::size_t searchThreads = 1;
+  // Bot searches that can run at the same time.
+  std::size_t computeThreads = 1;
+  // The engine plays from it while in book and HINT requests are
+  // answered from it. May be null.
+  const OpeningBook* book = nullptr;
+  // Ends a game as drawn as soon as the tablebases say it is a draw.
+  bool tablebaseAdjudication = false;
+};
+
+// The engine behind every bot seat of the server. Searches run on a
+// ComputePool rather than on the network threads, so a busy engine delays
+// other bot moves but never a human player's I/O. Each compute thread
+// owns its searchers.
+class BotEngine {
+ public:
+  explicit BotEngine(const BotOptions& options);
+
+  BotEngine(const BotEngine&) = delete;
+  BotEngine& operator=(const BotEngine&) = delete;
+
+  // Any thread. Picks a move for `position` and passes it to `done` on a
+  // compute thread, null if there is no legal move. `history` holds the
+  // keys of the game's earlier positions, oldest first, so that the bot
+  // sees repetitions. The time limit counts from this call, so time spent
+  // queued behind other searches is part of it.
+  void play(RoomId room, const Position& position, std::vector<Key> history, std::function<void(Move)> done);
+
+  const BotOptions& options() const { return options_; }
+
+ private:
+  struct Worker {
+    std::unique_ptr<TranspositionTable> table;  // null when sharing
+    std::unique_ptr<SearchPool> search;
+    RoomId lastRoom = 0;
+    std::uint64_t random = 0;
+  };
+
+  Move chooseMove(Worker& worker, RoomId room, const Position& position, std::span<const Key> history,
+                  const SearchLimits& limits);
+
+  BotOptions options_;
+  std::unique_ptr<TranspositionTable> sharedTable_;
+  std::vector<Worker> workers_;
+  // Last, so its threads are joined before the workers go away.
+  ComputePool pool_;
+};
+
+#endif //_BOT_ENGINE_H_
@@ -0,0 +1,58 @@
+#ifndef _COMPUTE_POOL_H_
+#define _COMPUTE_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool for CPU-heavy jobs (bot searches), kept off the
+// network threads. Each worker has its own task deque: submissions are
+// spread round-robin over them, a worker takes its oldest task first, and
+// a worker with an empty deque steals the newest task of another one.
+// The deque locks are only ever contended by a thief, and idle workers
+// sleep until something is submitted.
+class ComputePool {
+ public:
+  // `worker` is the index of the thread running the task, for tasks that
+  // keep per-thread state.
+  using Task = std::function<void(std::size_t worker)>;
+
+  explicit ComputePool(std::size_t threadCount);
+  ~ComputePool();
+
+  ComputePool(const ComputePool&) = delete;
+  ComputePool& operator=(const ComputePool&) = delete;
+
+  // Any thread. Tasks still queued when the pool is destroyed are dropped.
+  void submit(Task task);
+
+  std::size_t threadCount() const { return threads_.size(); }
+  // Submitted and not yet started.
+  std::size_t queued() const { return queued_.load(std::memory_order_relaxed); }
+
+ private:
+  struct alignas(64) Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void run(std::size_t index);
+  bool takeTask(std::size_t index, Task& task);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+  std::atomic<std::size_t> nextWorker_{0};
+  std::atomic<std::size_t> queued_{0};
+
+  std::mutex sleepMutex_;
+  std::condition_variable wake_;
+  bool quit_ = false;
+};
+
+#endif //_COMPUTE_POOL_H_
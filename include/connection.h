@@ -0,0 +1,74 @@
+#ifndef _CONNECTION_H_
+#define _CONNECTION_H_
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "framing.h"
+#include "outbound.h"
+#include "room.h"
+
+// What a connection has joined.
+struct Session {
+  RoomTable::Slot room = 0;
+  std::uint8_t role = 0;
+};
+
+// io_uring requests in flight on a connection. Its slot, and with it the
+// send buffer the kernel may still be reading, is only released once none
+// are left.
+struct RingRequests {
+  bool receiving = false;
+  bool sending = false;
+};
+
+// Everything a shard keeps about one connection, in one place, so that
+// handling a message is a single array index away from its socket.
+struct Connection {
+  int socket = -1;  // -1 while the slot is free
+  std::uint32_t generation = 0;
+  Session session;
+  bool closing = false;  // to be closed at the end of the event batch
+  bool closed = false;   // out of its room, waiting for io_uring to let go
+  RingRequests ring;
+  std::uint64_t bytesReceived = 0;
+  std::uint64_t bytesSent = 0;
+  FrameBuffer receiveBuffer;
+  OutboundBuffer sendBuffer;
+};
+
+// Slot index in the low half, the slot's generation above it.
+using ConnectionId = std::uint64_t;
+
+// Slab of connections, indexed by a small integer that rooms use as the
+// member handle. Slots are recycled, so whatever may outlive a connection
+// (an epoll event or io_uring completion later in the same batch, a queued
+// flush) holds a ConnectionId instead: the generation moves on when the
+// slot is released, and a stale id stops resolving. Slots never move, so
+// references stay valid while connections come and go.
+class ConnectionTable {
+ public:
+  using Index = std::uint32_t;
+  // Generations wrap at 24 bits, leaving the top byte of an id free for
+  // callers to tag it with.
+  static constexpr unsigned kGenerationBits = 24;
+
+  Index open(int socket);
+  void release(Index index);
+
+  Connection& operator[](Index index) { return slots_[index]; }
+
+  ConnectionId id(Index index) const;
+  // False if `id` refers to a slot that has been released since.
+  bool find(ConnectionId id, Index& index) const;
+
+  // Every slot, free ones (socket < 0) included.
+  std::deque<Connection>& slots() { return slots_; }
+
+ private:
+  std::deque<Connection> slots_;
+  std::vector<Index> freeSlots_;
+};
+
+#endif //_CONNECTION_H_
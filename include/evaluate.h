@@ -0,0 +1,45 @@
+#ifndef _EVALUATE_H_
+#define _EVALUATE_H_
+
+#include <array>
+#include <cstddef>
+
+#include "nnue.h"
+#include "position.h"
+#include "types.h"
+
+// Static evaluation in centipawns from the point of view of the side to
+// move: the network when one is loaded, material plus piece-square tables
+// otherwise.
+
+static constexpr int PIECE_VALUES[PIECE_TYPE_COUNT] = {0, 900, 500, 330, 320, 100};
+
+// From scratch; for one-off evaluations outside a search.
+int evaluate(const Position& position);
+
+// Evaluation state kept in step with a position during search. push()
+// follows each makeMove and only applies the pieces the move touched;
+// pop() follows unmakeMove and just drops back to the parent's state.
+class Evaluator {
+ public:
+  static constexpr std::size_t kMaxDepth = 128;
+
+  void reset(const Position& position);
+  // `position` is the position after `move`, `undo` what makeMove filled.
+  void push(const Position& position, Move move, const UndoInfo& undo);
+  void pop() { --top_; }
+
+  int evaluate(const Position& position) const;
+
+ private:
+  struct Accumulator {
+    int psq = 0;  // material and tables, white minus black
+    std::array<AccumulatorColumn, 2> hidden;  // by perspective
+  };
+
+  std::array<Accumulator, kMaxDepth> stack_;
+  std::size_t top_ = 0;
+  const Network* net_ = nullptr;
+};
+
+#endif //_EVALUATE_H_
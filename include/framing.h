@@ -0,0 +1,64 @@
+#ifndef _FRAMING_H_
+#define _FRAMING_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "const.h"
+
+// Every message on the wire is a frame: a 2 byte little-endian payload
+// length followed by the payload. Several frames may arrive in a single
+// read and a frame may be split across reads, so receivers accumulate
+// bytes in a FrameBuffer and pop complete frames from it.
+
+static constexpr std::size_t FRAME_HEADER_SIZE = 2;
+static constexpr std::size_t MAX_FRAME_PAYLOAD = MAX_MESSAGE_LENGTH;
+
+// Appends one framed message to `out`, so that several messages can be
+// coalesced into a single write. A payload that is empty or longer than
+// MAX_FRAME_PAYLOAD cannot be framed: returns false and leaves `out` as it
+// was.
+[[nodiscard]] bool appendFrame(std::string& out, std::string_view payload);
+
+// Fixed-size protocol records are checked when compiled, so this one
+// cannot fail.
+template <std::size_t N>
+void appendFrame(std::string& out, const std::array<char, N>& record) {
+  static_assert(N > 0 && N <= MAX_FRAME_PAYLOAD, "record does not fit in a frame");
+  out.push_back(static_cast<char>(N & 0xFF));
+  out.push_back(static_cast<char>(N >> 8));
+  out.append(record.data(), N);
+}
+
+enum class FrameStatus { kReady, kIncomplete, kInvalid };
+
+class FrameBuffer {
+ public:
+  static constexpr std::size_t kCapacity = 4096;
+  static_assert((kCapacity & (kCapacity - 1)) == 0, "capacity must be a power of two");
+
+  // Contiguous free space to receive into; may be smaller than the total
+  // free space when the free region wraps around the end of the ring.
+  std::span<char> writable();
+  void commit(std::size_t count);
+
+  // On kReady, `payload` views the next frame and stays valid until the
+  // buffer is read from or written to again. kInvalid means the peer sent a length we never produce.
+  FrameStatus nextFrame(std::string_view& payload);
+
+  std::size_t size() const { return tail_ - head_; }
+
+ private:
+  std::uint8_t byteAt(std::size_t offset) const { return static_cast<std::uint8_t>(data_[(head_ + offset) & (kCapacity - 1)]); }
+
+  std::array<char, kCapacity> data_{};
+  std::array<char, MAX_FRAME_PAYLOAD> scratch_{};
+  std::size_t head_ = 0;
+  std::size_t tail_ = 0;
+};
+
+#endif //_FRAMING_H_
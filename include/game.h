@@ -0,0 +1,34 @@
+#ifndef _GAME_H_
+#define _GAME_H_
+
+#include <cstdint>
+
+#include "bitboard.h"
+#include "position.h"
+#include "types.h"
+
+// Rules on top of the bitboard Position: validation and check detection
+// are attack-set intersections rather than board walks.
+
+// O(1): an attackers-to-square query, one lookup per piece kind.
+bool isSquareAttacked(const Position& position, Square square, Color by);
+bool isKingInCheck(const Position& position, Color kingColor);
+
+// Pseudo-legal: the piece can make this move, ignoring whether it leaves
+// its own king in check.
+bool isMoveValid(const Position& position, Move move);
+// Valid and does not leave the mover's king in check. The move is tried in
+// place and taken back, so `position` is unchanged on return.
+bool isMoveLegal(Position& position, Move move);
+
+// Both only answer for the side to move, and stop at the first legal move
+// found.
+bool isCheckmate(const Position& position, Color playerColor);
+bool isStalemate(const Position& position, Color playerColor);
+
+// Builds a Move from the from/to squares and promotion byte of a MOVE
+// record, inferring castling, en passant and promotion from the position.
+// Promotion defaults to a queen when the client does not pick one.
+Move moveFromWire(const Position& position, std::uint8_t from, std::uint8_t to, std::uint8_t promotion);
+
+#endif //_GAME_H_
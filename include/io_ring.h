@@ -0,0 +1,91 @@
+#ifndef _IO_RING_H_
+#define _IO_RING_H_
+
+#include <linux/io_uring.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// Minimal io_uring wrapper, on the raw system calls (no liburing). The
+// submission queue is filled with nextEntry() and handed to the kernel by
+// submitAndWait(), so a whole event loop iteration costs one system call.
+//
+// It also owns one provided buffer ring: receives armed with
+// IOSQE_BUFFER_SELECT pick a buffer from it, and the loop gives the buffer
+// back with recycle() once the bytes have been consumed.
+class IoRing {
+ public:
+  static constexpr std::uint16_t kBufferGroup = 0;
+
+  // `entries` submission slots and `bufferCount` receive buffers, both
+  // powers of two. Fails on kernels without io_uring, without provided
+  // buffer rings (5.19) or without multishot receive (6.0), or where
+  // io_uring is disabled.
+  IoRing(unsigned entries, unsigned bufferCount, unsigned bufferSize);
+  ~IoRing();
+
+  IoRing(const IoRing&) = delete;
+  IoRing& operator=(const IoRing&) = delete;
+
+  bool isValid() const { return ringFd_ >= 0 && bufferRing_ != nullptr && multishotReceive_; }
+
+  // A zeroed submission entry, submitting what is queued first when the
+  // queue is full. Null only if that submission fails.
+  io_uring_sqe* nextEntry();
+
+  // Submits everything queued and blocks until at least one completion is
+  // available.
+  bool submitAndWait();
+
+  // Calls `handler(cqe)` for every available completion, then releases them.
+  template <typename Handler>
+  void forEachCompletion(Handler&& handler) {
+    unsigned head = *cqHead_;
+    const unsigned tail = std::atomic_ref(*cqTail_).load(std::memory_order_acquire);
+    for (; head != tail; ++head)
+      handler(cqes_[head & cqMask_]);
+    std::atomic_ref(*cqHead_).store(head, std::memory_order_release);
+  }
+
+  std::span<const char> buffer(std::uint16_t id, std::size_t size) const {
+    return {buffers_ + static_cast<std::size_t>(id) * bufferSize_, size};
+  }
+  void recycle(std::uint16_t id);
+
+ private:
+  bool setupBufferRing();
+  // Runs one multishot receive on a socket pair; older kernels refuse the
+  // flag with -EINVAL, which would otherwise only show once clients connect.
+  bool probeMultishotReceive();
+
+  int ringFd_ = -1;
+  void* ringMemory_ = nullptr;
+  std::size_t ringBytes_ = 0;
+  io_uring_sqe* sqes_ = nullptr;
+  std::size_t sqeBytes_ = 0;
+
+  unsigned* sqHead_ = nullptr;
+  unsigned* sqTail_ = nullptr;
+  unsigned* sqArray_ = nullptr;
+  unsigned sqMask_ = 0;
+  unsigned sqEntries_ = 0;
+  unsigned sqLocalTail_ = 0;
+  unsigned toSubmit_ = 0;
+
+  unsigned* cqHead_ = nullptr;
+  unsigned* cqTail_ = nullptr;
+  io_uring_cqe* cqes_ = nullptr;
+  unsigned cqMask_ = 0;
+
+  io_uring_buf_ring* bufferRing_ = nullptr;
+  std::size_t bufferRingBytes_ = 0;
+  char* buffers_ = nullptr;
+  unsigned bufferCount_;
+  unsigned bufferSize_;
+  std::uint16_t bufferTail_ = 0;
+  bool multishotReceive_ = false;
+};
+
+#endif //_IO_RING_H_
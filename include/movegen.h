@@ -0,0 +1,56 @@
+#ifndef _MOVEGEN_H_
+#define _MOVEGEN_H_
+
+#include <array>
+#include <cstddef>
+
+#include "bitboard.h"
+#include "position.h"
+
+// Fixed-capacity move list that lives on the stack; no position has more
+// than 218 legal moves.
+class MoveList {
+ public:
+  static constexpr std::size_t kCapacity = 256;
+
+  void push(Move move) { moves_[size_++] = move; }
+  void clear() { size_ = 0; }
+
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  Move operator[](std::size_t index) const { return moves_[index]; }
+  Move& operator[](std::size_t index) { return moves_[index]; }
+
+  const Move* begin() const { return moves_.data(); }
+  const Move* end() const { return moves_.data() + size_; }
+  Move* begin() { return moves_.data(); }
+  Move* end() { return moves_.data() + size_; }
+
+  bool contains(Move move) const {
+    for (Move candidate : *this) {
+      if (candidate == move)
+        return true;
+    }
+    return false;
+  }
+
+ private:
+  std::array<Move, kCapacity> moves_;
+  std::size_t size_ = 0;
+};
+
+// Pieces of either color attacking `square` given an occupancy.
+Bitboard attackersTo(const Position& position, Square square, Bitboard occupied);
+
+// Every legal move for the side to move. Pins and check evasions are
+// resolved during generation, so no move is tried on a copy of the board.
+void generateLegalMoves(const Position& position, MoveList& moves);
+
+// Captures (en passant included) and promotions only, or every legal move
+// when the side to move is in check. Used by quiescence search.
+void generateLegalCaptures(const Position& position, MoveList& moves);
+
+// Stops at the first legal move found.
+bool hasLegalMove(const Position& position);
+
+#endif //_MOVEGEN_H_
@@ -0,0 +1,72 @@
+#ifndef _MPSC_QUEUE_H_
+#define _MPSC_QUEUE_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Bounded lock-free multi-producer / single-consumer queue (Vyukov's
+// sequence-numbered ring). Producers claim a cell with one CAS; the single
+// consumer never contends with them. push() fails instead of blocking
+// when the ring is full.
+template <typename T, std::size_t Capacity>
+class MpscQueue {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+ public:
+  MpscQueue() {
+    for (std::size_t i = 0; i < Capacity; ++i)
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  // Any thread.
+  bool push(T&& value) {
+    std::size_t position = enqueuePosition_.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &cells_[position & (Capacity - 1)];
+      const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+      if (difference == 0) {
+        if (enqueuePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+          break;
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = enqueuePosition_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->value = std::move(value);
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Owning thread only.
+  bool pop(T& value) {
+    Cell& cell = cells_[dequeuePosition_ & (Capacity - 1)];
+    const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+    if (sequence != dequeuePosition_ + 1)
+      return false;
+    value = std::move(cell.value);
+    cell.sequence.store(dequeuePosition_ + Capacity, std::memory_order_release);
+    ++dequeuePosition_;
+    return true;
+  }
+
+ private:
+  struct Cell {
+    std::atomic<std::size_t> sequence;
+    T value;
+  };
+
+  std::array<Cell, Capacity> cells_;
+  alignas(64) std::atomic<std::size_t> enqueuePosition_{0};
+  alignas(64) std::size_t dequeuePosition_ = 0;
+};
+
+#endif //_MPSC_QUEUE_H_
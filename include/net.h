@@ -0,0 +1,13 @@
+#ifndef _NET_H_
+#define _NET_H_
+
+// Thin POSIX socket helpers used by the server event loop.
+
+// Non-blocking listening socket on every interface. With `reusePort`,
+// several sockets can listen on the same port (SO_REUSEPORT).
+int listenTcp(unsigned short port, bool reusePort = false);
+bool setNoDelay(int fd);
+
+void closeSocket(int fd);
+
+#endif //_NET_H_
@@ -0,0 +1,63 @@
+#ifndef _NNUE_H_
+#define _NNUE_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "types.h"
+
+// Small efficiently updatable network: 768 inputs (colored piece x
+// square, seen from each side) -> NNUE_HIDDEN per side -> 1. The first
+// layer output (the accumulator) is kept up to date move by move, so a
+// full evaluation is one clipped ReLU and a 2 * NNUE_HIDDEN dot product.
+// Weights are int16; the hot loops run on AVX2, SSE4.1 or plain C++,
+// picked once at startup from what the CPU supports.
+
+static constexpr std::size_t NNUE_INPUTS = 768;
+static constexpr std::size_t NNUE_HIDDEN = 128;
+
+using AccumulatorColumn = std::array<std::int16_t, NNUE_HIDDEN>;
+
+// Feature index of `piece` on `square` from `perspective`'s side of the
+// board: black sees the board flipped with the colors swapped.
+constexpr std::size_t nnueFeature(Color perspective, PieceCode piece, Square square) {
+  if (perspective == Color::kWhite)
+    return piece * 64u + square;
+  const int swapped = (piece + PIECE_TYPE_COUNT) % (2 * PIECE_TYPE_COUNT);
+  return swapped * 64u + (square ^ 56);
+}
+
+struct Network {
+  std::vector<AccumulatorColumn> featureWeights;  // NNUE_INPUTS columns
+  AccumulatorColumn featureBias{};
+  std::array<std::int16_t, 2 * NNUE_HIDDEN> outputWeights{};  // side to move first
+  std::int32_t outputBias = 0;
+};
+
+// File layout, all little-endian: "NNUE" magic, u32 version (1), u32
+// hidden size, then featureWeights, featureBias, outputWeights as int16
+// and outputBias as int32. Returns false and keeps the current network
+// (if any) on a missing or mismatching file. Call before any search.
+bool loadNetwork(const char* path);
+// Null until a network has been loaded.
+const Network* network();
+
+// Centipawns for the side to move from its and the opponent's accumulator.
+int networkOutput(const Network& net, const AccumulatorColumn& us, const AccumulatorColumn& them);
+
+// dst = src + sum(add columns) - sum(sub columns).
+void updateAccumulator(AccumulatorColumn& dst, const AccumulatorColumn& src, const AccumulatorColumn* const* add,
+                       std::size_t addCount, const AccumulatorColumn* const* sub, std::size_t subCount);
+
+enum class SimdLevel : std::uint8_t { kScalar, kSse41, kAvx2 };
+
+// The best level this CPU supports; it is what the kernels use unless
+// useSimd() says otherwise (benchmarks compare levels with it).
+SimdLevel detectSimd();
+void useSimd(SimdLevel level);
+SimdLevel activeSimd();
+const char* simdName(SimdLevel level);
+
+#endif //_NNUE_H_
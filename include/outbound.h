@@ -0,0 +1,58 @@
+#ifndef _OUTBOUND_H_
+#define _OUTBOUND_H_
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <string>
+
+// Bytes waiting to go out on a non-blocking socket. Writes never wait:
+// whatever the kernel does not take stays queued here until the socket
+// reports it is writable again, so a slow reader only ever delays itself.
+//
+// Messages are immutable and shared: a broadcast is encoded once and the
+// same buffer is queued on every recipient, which then writes all its
+// pending messages with a single scatter-gather send.
+
+using SharedBytes = std::shared_ptr<const std::string>;
+
+inline SharedBytes makeShared(std::string bytes) {
+  return std::make_shared<const std::string>(std::move(bytes));
+}
+
+enum class FlushStatus { kDone, kPending, kError };
+
+class OutboundBuffer {
+ public:
+  // Messages handed to one sendmsg call.
+  static constexpr std::size_t kMaxBatch = 64;
+
+  void append(SharedBytes data);
+
+  // Writes until the buffer is empty (kDone) or the socket is full
+  // (kPending). kError means the peer is gone.
+  FlushStatus flush(int fd);
+
+  // For writers that complete asynchronously (io_uring): describes up to
+  // kMaxBatch queued messages for one sendmsg. The header points into this
+  // buffer and stays valid until consume(), even if more is appended.
+  const msghdr* prepare();
+  // Drops `written` bytes from the front.
+  void consume(std::size_t written);
+
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+ private:
+  std::deque<SharedBytes> messages_;
+  std::size_t offset_ = 0;  // already written from the first message
+  std::size_t size_ = 0;
+  std::array<iovec, kMaxBatch> chunks_;
+  msghdr header_{};
+};
+
+#endif //_OUTBOUND_H_
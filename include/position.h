@@ -0,0 +1,139 @@
+#ifndef _POSITION_H_
+#define _POSITION_H_
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include "bitboard.h"
+#include "types.h"
+#include "zobrist.h"
+
+enum class MoveKind : std::uint8_t { kNormal, kPromotion, kEnPassant, kCastling };
+
+// 16 bit move: from (6) | to (6) | promotion (2) | kind (2). Castling is
+// encoded as the king's move (e1g1, e1c1, ...).
+class Move {
+ public:
+  constexpr Move() = default;
+  constexpr Move(Square from, Square to, MoveKind kind = MoveKind::kNormal,
+                 PieceType promotion = PieceType::Queen)
+      : data_(static_cast<std::uint16_t>(from | (to << 6) |
+                                         ((static_cast<int>(promotion) - static_cast<int>(PieceType::Queen)) << 12) |
+                                         (static_cast<int>(kind) << 14))) {}
+
+  constexpr Square from() const { return data_ & 0x3F; }
+  constexpr Square to() const { return (data_ >> 6) & 0x3F; }
+  constexpr MoveKind kind() const { return static_cast<MoveKind>(data_ >> 14); }
+  constexpr PieceType promotion() const {
+    return static_cast<PieceType>(((data_ >> 12) & 3) + static_cast<int>(PieceType::Queen));
+  }
+
+  static constexpr Move fromRaw(std::uint16_t raw) {
+    Move move;
+    move.data_ = raw;
+    return move;
+  }
+
+  constexpr bool isNull() const { return data_ == 0; }
+  constexpr std::uint16_t raw() const { return data_; }
+  constexpr bool operator==(const Move&) const = default;
+
+ private:
+  std::uint16_t data_ = 0;
+};
+
+static constexpr std::uint8_t WHITE_OO = 1;
+static constexpr std::uint8_t WHITE_OOO = 2;
+static constexpr std::uint8_t BLACK_OO = 4;
+static constexpr std::uint8_t BLACK_OOO = 8;
+
+// Everything makeMove overwrites that unmakeMove cannot recompute from the
+// move itself.
+struct UndoInfo {
+  PieceCode captured = NO_PIECE;
+  std::uint8_t castling = 0;
+  std::uint8_t enPassant = NO_SQUARE;
+  std::uint16_t halfmoveClock = 0;
+  Key key = 0;
+};
+
+// Bitboard position: one bitboard per colored piece plus per-color and
+// total occupancy, with a mailbox kept alongside for O(1) "what is on this
+// square" lookups. King squares are maintained on every applied move, so
+// check detection is an attackers-to-square query (two slider lookups)
+// instead of a board scan. A side's whole attack map is not maintained: a
+// slider lookup is a single table load, so keeping the maps up to date on
+// every make and unmake costs more than building one where it is needed
+// (king moves and castling). The Zobrist key is updated incrementally
+// alongside; the en passant square is only recorded when a capture is
+// actually possible, so transpositions hash the same.
+class Position {
+ public:
+  Position() { board_.fill(NO_PIECE); }
+
+  static Position startPosition();
+  // Parses Forsyth-Edwards Notation. The move counters are optional;
+  // returns false and leaves `position` untouched on malformed input.
+  static bool fromFen(std::string_view fen, Position& position);
+  // Places pieces[i] on squares[i] with no castling or en passant rights;
+  // much cheaper than going through a FEN string. Returns false unless
+  // each side has one king and no two pieces share a square.
+  static bool fromPieces(std::span<const PieceCode> pieces, std::span<const Square> squares, Color sideToMove,
+                         Position& position);
+
+  Bitboard pieces(Color color, PieceType type) const { return pieces_[makePiece(color, type)]; }
+  Bitboard pieces(Color color) const { return occupancy_[static_cast<int>(color)]; }
+  Bitboard occupied() const { return occupied_; }
+
+  PieceCode pieceOn(Square square) const { return board_[square]; }
+  Color colorOn(Square square) const { return pieceColor(board_[square]); }
+  Square kingSquare(Color color) const { return kingSquares_[static_cast<int>(color)]; }
+  // Every square `color` attacks, computed on demand with sliders seeing
+  // through to `occupied`.
+  Bitboard attackedBy(Color color, Bitboard occupied) const;
+  Bitboard attackedBy(Color color) const { return attackedBy(color, occupied_); }
+
+  Color sideToMove() const { return sideToMove_; }
+  std::uint8_t castlingRights() const { return castling_; }
+  Square enPassantSquare() const { return enPassant_; }
+  int halfmoveClock() const { return halfmoveClock_; }
+  int fullmoveNumber() const { return fullmoveNumber_; }
+  Key key() const { return key_; }
+
+  // Plays a pseudo-legal move in place; `undo` receives what unmakeMove
+  // needs to take it back. The captured piece, if any, is undo.captured.
+  void makeMove(Move move, UndoInfo& undo);
+  void unmakeMove(Move move, const UndoInfo& undo);
+
+ private:
+  void put(PieceCode piece, Square square);
+  void remove(Square square);
+  Key computeKey() const;
+
+  std::array<Bitboard, 12> pieces_{};
+  std::array<Bitboard, 2> occupancy_{};
+  Bitboard occupied_ = 0;
+  std::array<PieceCode, 64> board_{};
+  std::array<Square, 2> kingSquares_{NO_SQUARE, NO_SQUARE};
+  Color sideToMove_ = Color::kWhite;
+  std::uint8_t castling_ = 0;
+  Square enPassant_ = NO_SQUARE;
+  int halfmoveClock_ = 0;
+  int fullmoveNumber_ = 1;
+  Key key_ = 0;
+};
+
+// Square of the piece taken by `move` (differs from move.to() for en passant).
+constexpr Square captureSquare(Move move, Color mover) {
+  if (move.kind() != MoveKind::kEnPassant)
+    return move.to();
+  return mover == Color::kWhite ? move.to() - 8 : move.to() + 8;
+}
+
+// Rook squares for a castling move given the king's destination.
+constexpr Square castlingRookFrom(Square kingTo) { return fileOf(kingTo) == 6 ? kingTo + 1 : kingTo - 2; }
+constexpr Square castlingRookTo(Square kingTo) { return fileOf(kingTo) == 6 ? kingTo - 1 : kingTo + 1; }
+
+#endif //_POSITION_H_
@@ -0,0 +1,284 @@
+#ifndef _PROTOCOL_H_
+#define _PROTOCOL_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Binary wire protocol. Each framed payload starts with an opcode byte
+// followed by a fixed-size record, so encoding and decoding never allocate
+// and never parse text. Squares are 0..63 with a1 = 0 and h8 = 63; board
+// coordinates (x, y) used by the game have y = 0 on black's back rank.
+//
+// Bump PROTOCOL_VERSION whenever a record layout changes; the server
+// announces it in the ROLE record and clients refuse mismatching servers.
+
+static constexpr std::uint8_t PROTOCOL_VERSION = 6;
+
+enum class Opcode : std::uint8_t {
+  kRole = 1,       // server -> client: version, role, room id
+  kMove = 2,       // both ways: role, piece, from, to, promotion, flags
+  kCapture = 3,    // server -> client: role of the captured piece, piece, square
+  kCheckmate = 4,  // server -> client: role of the winner
+  kChat = 5,       // client -> server: free text
+  kJoin = 6,       // client -> server: room id, flags
+  kStalemate = 7,  // server -> client: no payload, the game is drawn
+  kPosition = 8,   // server -> client: Zobrist key of the room's position
+  kHint = 9,       // client -> server: no payload; server -> client: book moves
+};
+
+// Roles as assigned by the server: PA plays white, PB plays black, anyone
+// joining a room whose seats are taken watches.
+static constexpr std::uint8_t ROLE_PA = 0;
+static constexpr std::uint8_t ROLE_PB = 1;
+static constexpr std::uint8_t ROLE_SPECTATOR = 2;
+
+static constexpr std::uint8_t NO_PROMOTION = 0xFF;
+
+static constexpr std::uint8_t MOVE_FLAG_CAPTURE = 1 << 0;
+static constexpr std::uint8_t MOVE_FLAG_CHECK = 1 << 1;
+
+// Asks for the server's engine to take the PB seat. Only honoured by a
+// room with no players yet; the joiner then plays white.
+static constexpr std::uint8_t JOIN_FLAG_BOT = 1 << 0;
+
+struct RoleRecord {
+  std::uint8_t version = PROTOCOL_VERSION;
+  std::uint8_t role = ROLE_PA;
+  std::uint32_t room = 0;
+};
+
+struct MoveRecord {
+  std::uint8_t role = ROLE_PA;
+  std::uint8_t piece = 0;  // PieceType, ignored by the server
+  std::uint8_t from = 0;
+  std::uint8_t to = 0;
+  std::uint8_t promotion = NO_PROMOTION;
+  std::uint8_t flags = 0;
+};
+
+struct CaptureRecord {
+  std::uint8_t role = ROLE_PA;
+  std::uint8_t piece = 0;
+  std::uint8_t square = 0;
+};
+
+struct CheckmateRecord {
+  std::uint8_t winner = ROLE_PA;
+};
+
+struct JoinRecord {
+  std::uint32_t room = 0;
+  std::uint8_t flags = 0;
+};
+
+// Up to HINT_MOVES opening book moves for the side to move, heaviest
+// first; count is 0 when the position is out of book.
+static constexpr std::size_t HINT_MOVES = 4;
+
+struct HintMove {
+  std::uint8_t from = 0;
+  std::uint8_t to = 0;
+  std::uint8_t promotion = NO_PROMOTION;
+};
+
+struct HintRecord {
+  std::uint8_t count = 0;
+  std::array<HintMove, HINT_MOVES> moves{};
+};
+
+// Sent after ROLE and after every applied move, so clients can detect
+// repetitions and key caches without rebuilding the board.
+struct PositionRecord {
+  std::uint64_t key = 0;
+};
+
+static constexpr std::size_t ROLE_RECORD_SIZE = 7;
+static constexpr std::size_t MOVE_RECORD_SIZE = 7;
+static constexpr std::size_t CAPTURE_RECORD_SIZE = 4;
+static constexpr std::size_t CHECKMATE_RECORD_SIZE = 2;
+static constexpr std::size_t JOIN_RECORD_SIZE = 6;
+static constexpr std::size_t STALEMATE_RECORD_SIZE = 1;
+static constexpr std::size_t POSITION_RECORD_SIZE = 9;
+static constexpr std::size_t HINT_REQUEST_SIZE = 1;
+static constexpr std::size_t HINT_RECORD_SIZE = 2 + 3 * HINT_MOVES;
+
+constexpr std::uint8_t toWireSquare(int x, int y) {
+  return static_cast<std::uint8_t>((7 - y) * 8 + x);
+}
+constexpr int wireSquareX(std::uint8_t square) { return square % 8; }
+constexpr int wireSquareY(std::uint8_t square) { return 7 - square / 8; }
+
+constexpr bool isWireSquare(std::uint8_t square) { return square < 64; }
+
+constexpr bool peekOpcode(std::string_view payload, Opcode& opcode) {
+  if (payload.empty())
+    return false;
+  opcode = static_cast<Opcode>(static_cast<std::uint8_t>(payload[0]));
+  return true;
+}
+
+namespace protocol_detail {
+constexpr char byte(std::uint8_t value) { return static_cast<char>(value); }
+constexpr std::uint8_t at(std::string_view payload, std::size_t index) {
+  return static_cast<std::uint8_t>(payload[index]);
+}
+// Multi-byte fields are little-endian.
+constexpr std::uint32_t u32At(std::string_view payload, std::size_t index) {
+  return at(payload, index) | (static_cast<std::uint32_t>(at(payload, index + 1)) << 8) |
+         (static_cast<std::uint32_t>(at(payload, index + 2)) << 16) |
+         (static_cast<std::uint32_t>(at(payload, index + 3)) << 24);
+}
+constexpr std::uint64_t u64At(std::string_view payload, std::size_t index) {
+  return u32At(payload, index) | (static_cast<std::uint64_t>(u32At(payload, index + 4)) << 32);
+}
+}  // namespace protocol_detail
+
+constexpr std::array<char, ROLE_RECORD_SIZE> encodeRole(const RoleRecord& record) {
+  using protocol_detail::byte;
+  return {byte(static_cast<std::uint8_t>(Opcode::kRole)), byte(record.version), byte(record.role),
+          byte(record.room & 0xFF), byte((record.room >> 8) & 0xFF), byte((record.room >> 16) & 0xFF),
+          byte(record.room >> 24)};
+}
+
+constexpr std::array<char, MOVE_RECORD_SIZE> encodeMove(const MoveRecord& record) {
+  using protocol_detail::byte;
+  return {byte(static_cast<std::uint8_t>(Opcode::kMove)), byte(record.role), byte(record.piece),
+          byte(record.from), byte(record.to), byte(record.promotion), byte(record.flags)};
+}
+
+constexpr std::array<char, CAPTURE_RECORD_SIZE> encodeCapture(const CaptureRecord& record) {
+  using protocol_detail::byte;
+  return {byte(static_cast<std::uint8_t>(Opcode::kCapture)), byte(record.role), byte(record.piece),
+          byte(record.square)};
+}
+
+constexpr std::array<char, CHECKMATE_RECORD_SIZE> encodeCheckmate(const CheckmateRecord& record) {
+  using protocol_detail::byte;
+  return {byte(static_cast<std::uint8_t>(Opcode::kCheckmate)), byte(record.winner)};
+}
+
+constexpr std::array<char, STALEMATE_RECORD_SIZE> encodeStalemate() {
+  return {protocol_detail::byte(static_cast<std::uint8_t>(Opcode::kStalemate))};
+}
+
+constexpr std::array<char, JOIN_RECORD_SIZE> encodeJoin(const JoinRecord& record) {
+  using protocol_detail::byte;
+  return {byte(static_cast<std::uint8_t>(Opcode::kJoin)), byte(record.room & 0xFF),
+          byte((record.room >> 8) & 0xFF), byte((record.room >> 16) & 0xFF), byte(record.room >> 24),
+          byte(record.flags)};
+}
+
+constexpr std::array<char, POSITION_RECORD_SIZE> encodePosition(const PositionRecord& record) {
+  using protocol_detail::byte;
+  std::array<char, POSITION_RECORD_SIZE> payload{byte(static_cast<std::uint8_t>(Opcode::kPosition))};
+  for (std::size_t i = 0; i < 8; ++i)
+    payload[1 + i] = byte((record.key >> (8 * i)) & 0xFF);
+  return payload;
+}
+
+constexpr std::array<char, HINT_REQUEST_SIZE> encodeHintRequest() {
+  return {protocol_detail::byte(static_cast<std::uint8_t>(Opcode::kHint))};
+}
+
+constexpr std::array<char, HINT_RECORD_SIZE> encodeHint(const HintRecord& record) {
+  using protocol_detail::byte;
+  std::array<char, HINT_RECORD_SIZE> payload{byte(static_cast<std::uint8_t>(Opcode::kHint)), byte(record.count)};
+  for (std::size_t i = 0; i < HINT_MOVES; ++i) {
+    payload[2 + 3 * i] = byte(record.moves[i].from);
+    payload[3 + 3 * i] = byte(record.moves[i].to);
+    payload[4 + 3 * i] = byte(record.moves[i].promotion);
+  }
+  return payload;
+}
+
+inline std::string encodeChat(std::string_view text) {
+  std::string payload(1, static_cast<char>(Opcode::kChat));
+  payload += text;
+  return payload;
+}
+
+// Decoders check the opcode and exact record size; they return false on
+// anything malformed instead of throwing.
+
+constexpr bool decodeRole(std::string_view payload, RoleRecord& record) {
+  using protocol_detail::at;
+  if (payload.size() != ROLE_RECORD_SIZE || at(payload, 0) != static_cast<std::uint8_t>(Opcode::kRole))
+    return false;
+  record = {at(payload, 1), at(payload, 2), protocol_detail::u32At(payload, 3)};
+  return true;
+}
+
+constexpr bool decodeMove(std::string_view payload, MoveRecord& record) {
+  using protocol_detail::at;
+  if (payload.size() != MOVE_RECORD_SIZE || at(payload, 0) != static_cast<std::uint8_t>(Opcode::kMove))
+    return false;
+  record = {at(payload, 1), at(payload, 2), at(payload, 3), at(payload, 4), at(payload, 5), at(payload, 6)};
+  return isWireSquare(record.from) && isWireSquare(record.to);
+}
+
+constexpr bool decodeCapture(std::string_view payload, CaptureRecord& record) {
+  using protocol_detail::at;
+  if (payload.size() != CAPTURE_RECORD_SIZE || at(payload, 0) != static_cast<std::uint8_t>(Opcode::kCapture))
+    return false;
+  record = {at(payload, 1), at(payload, 2), at(payload, 3)};
+  return isWireSquare(record.square);
+}
+
+constexpr bool decodeCheckmate(std::string_view payload, CheckmateRecord& record) {
+  using protocol_detail::at;
+  if (payload.size() != CHECKMATE_RECORD_SIZE ||
+      at(payload, 0) != static_cast<std::uint8_t>(Opcode::kCheckmate))
+    return false;
+  record = {at(payload, 1)};
+  return true;
+}
+
+constexpr bool decodeStalemate(std::string_view payload) {
+  return payload.size() == STALEMATE_RECORD_SIZE &&
+         protocol_detail::at(payload, 0) == static_cast<std::uint8_t>(Opcode::kStalemate);
+}
+
+constexpr bool decodeJoin(std::string_view payload, JoinRecord& record) {
+  using protocol_detail::at;
+  if (payload.size() != JOIN_RECORD_SIZE || at(payload, 0) != static_cast<std::uint8_t>(Opcode::kJoin))
+    return false;
+  record = {protocol_detail::u32At(payload, 1), at(payload, 5)};
+  return true;
+}
+
+constexpr bool decodePosition(std::string_view payload, PositionRecord& record) {
+  using protocol_detail::at;
+  if (payload.size() != POSITION_RECORD_SIZE || at(payload, 0) != static_cast<std::uint8_t>(Opcode::kPosition))
+    return false;
+  record = {protocol_detail::u64At(payload, 1)};
+  return true;
+}
+
+constexpr bool decodeHintRequest(std::string_view payload) {
+  return payload.size() == HINT_REQUEST_SIZE &&
+         protocol_detail::at(payload, 0) == static_cast<std::uint8_t>(Opcode::kHint);
+}
+
+constexpr bool decodeHint(std::string_view payload, HintRecord& record) {
+  using protocol_detail::at;
+  if (payload.size() != HINT_RECORD_SIZE || at(payload, 0) != static_cast<std::uint8_t>(Opcode::kHint) ||
+      at(payload, 1) > HINT_MOVES)
+    return false;
+  record.count = at(payload, 1);
+  for (std::size_t i = 0; i < HINT_MOVES; ++i) {
+    record.moves[i] = {at(payload, 2 + 3 * i), at(payload, 3 + 3 * i), at(payload, 4 + 3 * i)};
+    if (i < record.count && (!isWireSquare(record.moves[i].from) || !isWireSquare(record.moves[i].to)))
+      return false;
+  }
+  return true;
+}
+
+template <std::size_t N>
+constexpr std::string_view asPayload(const std::array<char, N>& record) {
+  return {record.data(), N};
+}
+
+#endif //_PROTOCOL_H_
@@ -0,0 +1,40 @@
+#ifndef _REACTOR_H_
+#define _REACTOR_H_
+
+#include <sys/epoll.h>
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+// Edge-triggered epoll event loop. Handlers must drain a descriptor
+// (accept/recv until EAGAIN) each time it is reported ready, since no
+// further notification comes until new data arrives.
+class Reactor {
+ public:
+  static constexpr std::size_t kMaxEvents = 256;
+
+  Reactor();
+  ~Reactor();
+
+  Reactor(const Reactor&) = delete;
+  Reactor& operator=(const Reactor&) = delete;
+
+  bool isValid() const { return epollFd_ >= 0; }
+
+  bool add(int fd, std::uint32_t events);
+  // Reports the descriptor with `tag` in data.u64 instead of its number.
+  bool add(int fd, std::uint32_t events, std::uint64_t tag);
+  bool modify(int fd, std::uint32_t events);
+  bool remove(int fd);
+
+  // Blocks until at least one descriptor is ready or the timeout expires
+  // (-1 waits forever). The returned span is valid until the next call.
+  std::span<const epoll_event> wait(int timeoutMs);
+
+ private:
+  int epollFd_;
+  std::array<epoll_event, kMaxEvents> events_{};
+};
+
+#endif //_REACTOR_H_
@@ -0,0 +1,76 @@
+#ifndef _ROOM_H_
+#define _ROOM_H_
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "position.h"
+
+using RoomId = std::uint32_t;
+
+// Players and members are shard connection indices.
+static constexpr int NO_PLAYER = -1;
+// Seat taken by the server's engine rather than a connection.
+static constexpr int BOT_PLAYER = -2;
+
+// Hot per-game state. Rooms live by value in one contiguous vector so the
+// move path touches a single cache-friendly block per game; the member
+// lists used only for broadcasting are kept in a parallel vector.
+struct Room {
+  RoomId id = 0;
+  std::array<int, 2> players{NO_PLAYER, NO_PLAYER};  // PA (white), PB (black)
+  Position position;
+  // Keys of the positions since the last capture or pawn move, the current
+  // one excluded, so the bot can tell a repetition of the game's own.
+  std::vector<Key> keyHistory;
+  // Set once the game has ended, by mate or by a draw the server declared
+  // (stalemate, tablebase adjudication); moves are ignored from then on.
+  bool over = false;
+
+  bool isFull() const { return players[0] != NO_PLAYER && players[1] != NO_PLAYER; }
+  bool hasBot() const { return players[1] == BOT_PLAYER; }
+
+  // Called once a move has been played on `position`, with the key the
+  // position had before it.
+  void recordMove(Key previous) {
+    if (position.halfmoveClock() == 0)
+      keyHistory.clear();
+    else
+      keyHistory.push_back(previous);
+  }
+};
+
+class RoomTable {
+ public:
+  using Slot = std::uint32_t;
+
+  explicit RoomTable(std::size_t expectedRooms = 1024);
+
+  // Returns the slot of the room with this id, creating a fresh game if it
+  // does not exist yet.
+  Slot open(RoomId id);
+  // False when no room with this id is open.
+  bool find(RoomId id, Slot& slot) const;
+
+  Room& operator[](Slot slot) { return rooms_[slot]; }
+  const Room& operator[](Slot slot) const { return rooms_[slot]; }
+
+  // Every connection in the room, players and spectators alike.
+  std::vector<int>& members(Slot slot) { return members_[slot]; }
+
+  void join(Slot slot, int member);
+  // Removes the member from the room and frees the room once it is empty.
+  void leave(Slot slot, int member);
+
+  std::size_t size() const { return index_.size(); }
+
+ private:
+  std::vector<Room> rooms_;
+  std::vector<std::vector<int>> members_;
+  std::vector<Slot> freeSlots_;
+  std::unordered_map<RoomId, Slot> index_;
+};
+
+#endif //_ROOM_H_
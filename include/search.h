@@ -0,0 +1,99 @@
+#ifndef _SEARCH_H_
+#define _SEARCH_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <span>
+
+#include "evaluate.h"
+#include "movegen.h"
+#include "position.h"
+#include "tt.h"
+
+// Iterative deepening alpha-beta with quiescence search, used for the
+// server's bot opponents. Scores are centipawns from the side to move's
+// point of view; being mated in n plies scores -(SCORE_MATE - n).
+
+static constexpr int MAX_PLY = 64;
+static constexpr int SCORE_INFINITE = 32000;
+static constexpr int SCORE_MATE = 31000;
+// Scores past this are forced mates, found in the tree or read from a
+// tablebase, where they can be a couple of hundred plies away.
+static constexpr int SCORE_MATE_BOUND = SCORE_MATE - 512;
+
+// The clock, the node budget and the stop flag are polled every few
+// hundred nodes, and the search unwinds as soon as one of them trips, so
+// it comes back with its best move so far within moveTime however deep it
+// was.
+struct SearchLimits {
+  int depth = MAX_PLY;
+  // Hard deadline. The search stops a tenth of it (2 ms at most) early to
+  // leave room for unwinding, and starts no new iteration once half of it
+  // is gone, since that iteration would rarely finish in time.
+  std::chrono::milliseconds moveTime{100};
+  // Nodes for the calling thread, 0 for no limit.
+  std::uint64_t nodes = 0;
+  // Setting it makes the search return early.
+  const std::atomic<bool>* stop = nullptr;
+  // When moveTime started running; left empty, when the search starts.
+  // Lets time a request spent queued count against its budget.
+  std::chrono::steady_clock::time_point start{};
+};
+
+struct SearchResult {
+  Move best;  // null when the side to move has no legal move
+  int score = 0;
+  int depth = 0;
+  std::uint64_t nodes = 0;
+};
+
+// A Searcher is single-threaded and owns its own copy of the position, so
+// one per event loop thread can serve every bot room on it. Killer and
+// history tables are reset at the start of each search; the transposition
+// table is not owned and may be shared with other searchers, so ageing it
+// (table.newSearch()) is up to the caller.
+//
+// Searchers with an odd `firstDepth` offset start iterative deepening one
+// ply deeper, which is what keeps Lazy SMP helpers from all walking the
+// same tree in lockstep.
+class Searcher {
+ public:
+  explicit Searcher(TranspositionTable& table, int firstDepth = 1) : table_(table), firstDepth_(firstDepth) {}
+
+  // `history` holds the keys of the game's positions before the root,
+  // oldest first, so that repeating one of them counts as a draw too. It
+  // must stay alive for the duration of the search.
+  SearchResult search(const Position& root, const SearchLimits& limits, std::span<const Key> history = {});
+
+ private:
+  int alphaBeta(int depth, int ply, int alpha, int beta);
+  int quiescence(int ply, int alpha, int beta);
+  // The move with the best tablebase outcome when the root and all its
+  // successors are covered.
+  bool tablebaseMove(const MoveList& moves, SearchResult& result);
+  using MoveScores = std::array<int, MoveList::kCapacity>;
+
+  // Ordering keys: `first` (the previous best), captures and promotions by
+  // MVV-LVA, killers, then quiet moves by history.
+  void scoreMoves(const MoveList& moves, MoveScores& scores, int ply, Move first) const;
+  bool isRepetition(int ply) const;
+  bool shouldStop();
+
+  TranspositionTable& table_;
+  int firstDepth_;
+  const std::atomic<bool>* stop_ = nullptr;
+  std::uint64_t nodeLimit_ = 0;
+  Position position_;
+  Evaluator evaluator_;
+  std::array<Key, MAX_PLY + 1> keys_{};
+  std::span<const Key> gameKeys_;
+  std::array<std::array<Move, 2>, MAX_PLY> killers_{};
+  std::array<std::array<std::array<int, 64>, 64>, 2> history_{};
+  std::uint64_t nodes_ = 0;
+  std::chrono::steady_clock::time_point deadline_;
+  bool stopped_ = false;
+};
+
+#endif //_SEARCH_H_
@@ -0,0 +1,57 @@
+#ifndef _SEARCH_POOL_H_
+#define _SEARCH_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "search.h"
+#include "tt.h"
+
+// Lazy SMP: every thread runs its own iterative deepening on the same
+// root and they cooperate only through the shared transposition table.
+// The caller's thread is the main searcher and owns the clock; helpers are
+// started once and sleep between searches, so a move costs a wake-up
+// rather than a thread creation. With one thread nothing is spawned.
+class SearchPool {
+ public:
+  SearchPool(TranspositionTable& table, std::size_t threadCount);
+  ~SearchPool();
+
+  SearchPool(const SearchPool&) = delete;
+  SearchPool& operator=(const SearchPool&) = delete;
+
+  // Not reentrant: one search at a time per pool. The result comes from
+  // whichever thread completed the deepest iteration; nodes are summed.
+  // `history` as for Searcher::search.
+  SearchResult search(const Position& root, const SearchLimits& limits, std::span<const Key> history = {});
+
+  std::size_t threadCount() const { return searchers_.size(); }
+
+ private:
+  void helperLoop(std::size_t index);
+
+  TranspositionTable& table_;
+  std::vector<std::unique_ptr<Searcher>> searchers_;
+  std::vector<SearchResult> results_;
+  std::vector<std::thread> helpers_;
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable finished_;
+  std::uint64_t job_ = 0;
+  std::size_t busyHelpers_ = 0;
+  bool quit_ = false;
+  Position root_;
+  std::span<const Key> history_;
+  SearchLimits helperLimits_;
+  std::atomic<bool> stopHelpers_{false};
+};
+
+#endif //_SEARCH_POOL_H_
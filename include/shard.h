@@ -0,0 +1,164 @@
+#ifndef _SHARD_H_
+#define _SHARD_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "bot_engine.h"
+#include "connection.h"
+#include "framing.h"
+#include "io_ring.h"
+#include "mpsc_queue.h"
+#include "outbound.h"
+#include "reactor.h"
+#include "room.h"
+
+// A connection that has sent JOIN, on its way from the acceptor to the
+// shard owning its room. Bytes that arrived after the JOIN frame travel
+// along in the receive buffer.
+struct Handoff {
+  int socket = -1;
+  RoomId room = 0;
+  std::uint8_t joinFlags = 0;
+  std::unique_ptr<FrameBuffer> buffer;
+};
+
+// A bot move coming back from the engine, for the position with this key.
+struct BotReply {
+  RoomId room = 0;
+  Key key = 0;
+  Move move;
+};
+
+// Write backlog of a shard's connections, readable from any thread.
+struct OutboundStats {
+  std::size_t queuedBytes = 0;      // queued on all connections right now
+  std::size_t peakQueuedBytes = 0;  // largest backlog a connection has had
+  std::uint64_t slowDisconnects = 0;
+};
+
+enum class IoBackend { kEpoll, kIoUring };
+
+// One event loop thread. A shard exclusively owns its connections and rooms, so nothing on the game path takes a lock; the only shared
+// structures are the handoff inbox and the queue bot moves come back on.
+class Shard {
+ public:
+  static constexpr std::size_t kInboxCapacity = 1024;
+  static constexpr std::size_t kDefaultSendLimit = 256 * 1024;
+  static constexpr unsigned kRingEntries = 1024;
+  static constexpr unsigned kReceiveBuffers = 512;
+  static constexpr unsigned kReceiveBufferSize = 2048;
+
+  // The engine is shared by every shard. The loop calls into it and its
+  // threads post bot moves back, so it has to be destroyed after every
+  // shard it serves has stopped, and before they are destroyed. A
+  // connection with more than `sendLimit` bytes it has not read yet is
+  // dropped.
+  // kIoUring falls back to epoll where io_uring is unavailable; backend()
+  // tells which one the shard ended up with.
+  Shard(BotEngine& engine, std::size_t sendLimit, IoBackend backend);
+  ~Shard();
+
+  Shard(const Shard&) = delete;
+  Shard& operator=(const Shard&) = delete;
+
+  // Spawns the event loop thread, pinned to `cpu` when cpu >= 0.
+  bool start(int cpu);
+  void stop();
+
+  // Called from the acceptor thread. Fails when the inbox is full.
+  bool post(Handoff&& handoff);
+
+  OutboundStats outboundStats() const;
+  IoBackend backend() const { return ring_ ? IoBackend::kIoUring : IoBackend::kEpoll; }
+
+ private:
+  using Index = ConnectionTable::Index;
+
+  void run();
+  void wake();
+  void drainInbox();
+  void adopt(Handoff& handoff);
+  void receiveFrom(Index connection);
+  // Handles every complete frame in the connection's receive buffer.
+  // False once the connection is going away.
+  bool handleFrames(Index connection);
+  void handleMessage(Index connection, std::string_view payload);
+  void handleMove(const Session& session, std::string_view payload);
+  void handleHint(Index connection, const Session& session);
+  // Broadcasts a move that has already been played on the room's position.
+  void announceMove(RoomTable::Slot slot, std::uint8_t role, Move move, PieceCode movingPiece,
+                    PieceCode capturedPiece);
+  // Asks the engine for a move when it is on move in a bot room; the
+  // answer comes back through botReplies_.
+  void playBotMove(RoomTable::Slot slot);
+  // Plays the engine's answer unless the game has moved on meanwhile.
+  void applyBotMove(const BotReply& reply);
+  void broadcast(RoomTable::Slot slot, const SharedBytes& message);
+  // Queues `data`, which is written at the end of the event batch together
+  // with anything else queued meanwhile, in one sendmsg; what the socket
+  // does not take goes out on EPOLLOUT. Never closes the connection
+  // itself, as callers may be iterating over the room: a connection past
+  // the send limit or with a dead socket is closed after the flush.
+  void send(Index connection, const SharedBytes& data);
+  void flushUnflushed();
+  void flushOutbound(Index connection);
+  void accountQueued(std::size_t before, std::size_t after);
+  void closeLater(Index connection);
+  bool isClosing(Index connection) {
+    const Connection& entry = connections_[connection];
+    return entry.closing || entry.closed;
+  }
+  void closePending();
+  void disconnect(Index connection);
+
+  // io_uring backend: a multishot receive per connection filling buffers
+  // from the ring's pool, one SENDMSG in flight per connection and a
+  // multishot poll on the wake descriptor. Each loop iteration submits and
+  // reaps everything with a single io_uring_enter.
+  void runRing();
+  void handleCompletion(const io_uring_cqe& cqe);
+  void completeReceive(Index connection, const io_uring_cqe& cqe);
+  void completeSend(Index connection, int result);
+  void armWake();
+  void armReceive(Index connection);
+  void submitSend(Index connection);
+  void releaseIfIdle(Index connection);
+
+  Reactor reactor_;
+  int wakeFd_;
+  std::atomic<bool> running_{false};
+  std::thread thread_;
+  MpscQueue<Handoff, kInboxCapacity> inbox_;
+  MpscQueue<BotReply, kInboxCapacity> botReplies_;
+
+  RoomTable rooms_;
+  ConnectionTable connections_;
+  std::vector<ConnectionId> unflushed_;
+  std::vector<ConnectionId> closing_;
+  std::size_t sendLimit_;
+
+  // Written by the shard thread only.
+  std::atomic<std::size_t> queuedBytes_{0};
+  std::atomic<std::size_t> peakQueuedBytes_{0};
+  std::atomic<std::uint64_t> slowDisconnects_{0};
+
+  // Null on epoll. Declared after the connections so it is torn down
+  // first: the kernel may still reference their buffers until then.
+  std::unique_ptr<IoRing> ring_;
+
+  BotEngine& engine_;
+};
+
+// Rooms are spread over shards by a multiplicative hash of their id, so a
+// room (and every connection in it) always lands on the same core.
+inline std::size_t shardForRoom(RoomId room, std::size_t shardCount) {
+  return static_cast<std::size_t>((static_cast<std::uint64_t>(room) * 0x9E3779B97F4A7C15ull) >> 32) % shardCount;
+}
+
+#endif //_SHARD_H_
@@ -0,0 +1,85 @@
+#ifndef _TABLEBASE_H_
+#define _TABLEBASE_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "position.h"
+
+// Endgame tablebases built locally by the tbgen tool. There is one file
+// per material signature ("KQvKR.tb"). For every placement of the pieces
+// and either side to move, it holds the distance to mate in plies. Entries
+// are run-length compressed in fixed-size blocks behind an offset index, so
+// a probe decodes part of a single block of a memory-mapped file.
+// Positions with castling rights or an en passant square are not covered.
+
+static constexpr int TABLEBASE_MAX_PIECES = 5;
+static constexpr std::size_t TABLEBASE_BLOCK_ENTRIES = 1024;
+
+// File layout, all little-endian: u32 magic "TBL1", u32 version (1),
+// u32 piece count, u32 entries per block, u64 block count, u8 piece codes
+// (padded to 8), u64 offsets[block count + 1] into the payload, then the
+// payload as (u8 run length, u8 value) pairs.
+static constexpr std::uint32_t TABLEBASE_MAGIC = 0x314C4254;
+static constexpr std::uint32_t TABLEBASE_VERSION = 1;
+static constexpr std::size_t TABLEBASE_HEADER_SIZE = 32;
+
+// Entry values: 0 is a draw (or a position that cannot occur), 1 + n is
+// decided n plies from mate. n is odd when the side to move mates and
+// even when it gets mated.
+static constexpr std::uint8_t TABLEBASE_DRAW = 0;
+static constexpr int TABLEBASE_MAX_DTM = 252;
+
+enum class Wdl : std::int8_t { kLoss = -1, kDraw = 0, kWin = 1 };
+
+struct TablebaseResult {
+  Wdl wdl = Wdl::kDraw;
+  int dtm = 0;  // plies to mate, 0 for draws
+};
+
+constexpr TablebaseResult tablebaseResult(std::uint8_t value) {
+  if (value == TABLEBASE_DRAW)
+    return {};
+  const int dtm = value - 1;
+  return {dtm % 2 == 1 ? Wdl::kWin : Wdl::kLoss, dtm};
+}
+
+// A material signature: white's pieces then black's, each side king first
+// and then queen down to pawn. Tables are only built for the canonical
+// orientation, where white has the stronger side; positions with the
+// colors the other way round are probed with the board flipped.
+struct Material {
+  std::array<PieceCode, TABLEBASE_MAX_PIECES> pieces{};
+  int count = 0;
+};
+
+// "KQvKR" (either side may be written first); false on anything else.
+bool parseMaterial(std::string_view name, Material& material);
+std::string materialName(const Material& material);
+// Piece counts per colored piece, 4 bits each.
+std::uint64_t materialKey(const Material& material);
+std::uint64_t materialKey(const Position& position);
+// Canonical material of the position; `flipped` is set when its colors
+// are the other way round.
+Material materialOf(const Position& position, bool& flipped);
+
+// Index = square of piece 0 + 64 * square of piece 1 + ... + 64^count *
+// side to move, squares as seen in the canonical orientation.
+constexpr std::uint64_t tablebaseEntries(const Material& material) {
+  return std::uint64_t{2} << (6 * material.count);
+}
+std::uint64_t tablebaseIndex(const Material& material, const Position& position, bool flipped);
+
+// Maps every *.tb file in `directory`. Like loadNetwork(), call before any
+// search starts. Returns how many tables were loaded.
+std::size_t loadTablebases(const char* directory);
+// Pieces in the largest table loaded, 0 when there is none.
+int tablebasePieces();
+
+// False when the position is not covered.
+bool probeTablebase(const Position& position, TablebaseResult& result);
+
+#endif //_TABLEBASE_H_
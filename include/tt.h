@@ -0,0 +1,91 @@
+#ifndef _TT_H_
+#define _TT_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "position.h"
+#include "zobrist.h"
+
+enum class Bound : std::uint8_t { kNone, kUpper, kLower, kExact };
+
+struct TableEntry {
+  Move move;
+  int score = 0;
+  int depth = 0;
+  Bound bound = Bound::kNone;
+};
+
+// Fixed-size transposition table shared by any number of search threads
+// without locks. An entry is two relaxed 64 bit words, the packed data and
+// key ^ data; a reader that sees a torn write gets a key that does not
+// match and treats it as a miss, so the worst a race costs is one lost
+// entry. Four entries make a 64 byte bucket, so a probe touches a single
+// cache line.
+class TranspositionTable {
+ public:
+  static constexpr std::size_t kBucketSize = 4;
+
+  explicit TranspositionTable(std::size_t megabytes = 16);
+
+  TranspositionTable(const TranspositionTable&) = delete;
+  TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+  // None of these may run while a search is using the table.
+  void resize(std::size_t megabytes);
+  void clear();
+  // Ages every stored entry by one search, making it the first to go.
+  // Searches running side by side on one table may each call it; they
+  // then simply share a generation.
+  void newSearch() {
+    generation_.store((generation_.load(std::memory_order_relaxed) + 1) & kGenerationMask,
+                      std::memory_order_relaxed);
+  }
+  // Ages every stored entry by half the generation range, so each loses to
+  // anything stored afterwards. A constant time stand-in for clear() when
+  // the next searches are about an unrelated game: old entries can still
+  // be hit (a position's result does not depend on the game it came from)
+  // but no longer crowd out the new game's.
+  void retire() {
+    generation_.store((generation_.load(std::memory_order_relaxed) + kGenerationMask / 2 + 1) & kGenerationMask,
+                      std::memory_order_relaxed);
+  }
+
+  bool probe(Key key, TableEntry& entry) const;
+  // Keeps the deeper of two results for the same position; otherwise
+  // evicts the shallowest entry of the bucket, preferring old ones.
+  void store(Key key, int depth, int score, Bound bound, Move move);
+
+  // Starts loading the bucket of `key` so a probe a few hundred cycles
+  // later does not wait on memory.
+  void prefetch(Key key) const { __builtin_prefetch(&buckets_[index(key)]); }
+
+  std::size_t megabytes() const { return bucketCount_ * sizeof(Bucket) >> 20; }
+
+ private:
+  static constexpr std::uint8_t kGenerationMask = 0x3F;
+
+  struct Slot {
+    std::atomic<std::uint64_t> check{0};  // key ^ data
+    std::atomic<std::uint64_t> data{0};
+  };
+
+  struct alignas(64) Bucket {
+    Slot slots[kBucketSize];
+  };
+  static_assert(sizeof(Bucket) == 64, "a bucket must fill one cache line");
+
+  // Maps the key onto [0, bucketCount) with a multiply, so the table size
+  // does not have to be a power of two.
+  std::size_t index(Key key) const {
+    return static_cast<std::size_t>((static_cast<unsigned __int128>(key) * bucketCount_) >> 64);
+  }
+
+  std::unique_ptr<Bucket[]> buckets_;
+  std::size_t bucketCount_ = 0;
+  std::atomic<std::uint8_t> generation_{0};
+};
+
+#endif //_TT_H_
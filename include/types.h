@@ -0,0 +1,45 @@
+#ifndef _TYPES_H_
+#define _TYPES_H_
+
+#include <cstdint>
+
+// Chess primitives shared by the rules engine, the server and the client.
+
+enum class Color : std::uint8_t { kWhite, kBlack, kNone };
+
+// The numeric values are part of the wire protocol (MOVE/CAPTURE records).
+enum class PieceType : std::uint8_t { King, Queen, Rook, Bishop, Knight, Pawn };
+
+static constexpr int PIECE_TYPE_COUNT = 6;
+
+constexpr Color opposite(Color color) {
+  return color == Color::kWhite ? Color::kBlack : Color::kWhite;
+}
+
+// Squares are 0..63 with a1 = 0, b1 = 1, ..., h8 = 63 -- the same numbering
+// as the wire protocol. Board coordinates (x, y) as drawn by the client have
+// y = 0 on black's back rank.
+using Square = int;
+static constexpr Square NO_SQUARE = 64;
+
+constexpr Square squareFromXY(int x, int y) { return (7 - y) * 8 + x; }
+constexpr int squareX(Square square) { return square & 7; }
+constexpr int squareY(Square square) { return 7 - (square >> 3); }
+constexpr int fileOf(Square square) { return square & 7; }
+constexpr int rankOf(Square square) { return square >> 3; }
+
+// A colored piece packed in one byte: color * 6 + type, NO_PIECE if empty.
+using PieceCode = std::uint8_t;
+static constexpr PieceCode NO_PIECE = 12;
+
+constexpr PieceCode makePiece(Color color, PieceType type) {
+  return static_cast<PieceCode>(static_cast<int>(color) * PIECE_TYPE_COUNT + static_cast<int>(type));
+}
+constexpr Color pieceColor(PieceCode piece) {
+  return piece == NO_PIECE ? Color::kNone : static_cast<Color>(piece / PIECE_TYPE_COUNT);
+}
+constexpr PieceType pieceType(PieceCode piece) {
+  return static_cast<PieceType>(piece % PIECE_TYPE_COUNT);
+}
+
+#endif //_TYPES_H_
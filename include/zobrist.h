@@ -0,0 +1,66 @@
+#ifndef _ZOBRIST_H_
+#define _ZOBRIST_H_
+
+#include <array>
+#include <cstdint>
+
+#include "types.h"
+
+// Zobrist keys: one random 64 bit number per (piece, square), castling
+// state, en passant file and side to move. A position's key is the XOR of
+// the numbers that describe it, so a move updates it with a handful of
+// XORs. The numbers come from a fixed seed and are generated at compile
+// time, so keys are stable across builds and can be stored on disk.
+
+using Key = std::uint64_t;
+
+namespace zobrist_detail {
+
+struct Keys {
+  std::array<std::array<Key, 64>, 12> pieces{};
+  std::array<Key, 16> castling{};
+  std::array<Key, 8> enPassant{};
+  Key side = 0;
+};
+
+// splitmix64
+constexpr Key nextRandom(Key& state) {
+  Key z = (state += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+constexpr Keys makeKeys() {
+  Keys keys;
+  Key state = 0x2545F4914F6CDD1Dull;
+  for (auto& squares : keys.pieces) {
+    for (Key& key : squares)
+      key = nextRandom(state);
+  }
+  // One number per right; a combination is the XOR of its rights.
+  std::array<Key, 4> rights{};
+  for (Key& key : rights)
+    key = nextRandom(state);
+  for (int mask = 0; mask < 16; ++mask) {
+    for (int right = 0; right < 4; ++right) {
+      if (mask & (1 << right))
+        keys.castling[mask] ^= rights[right];
+    }
+  }
+  for (Key& key : keys.enPassant)
+    key = nextRandom(state);
+  keys.side = nextRandom(state);
+  return keys;
+}
+
+inline constexpr Keys KEYS = makeKeys();
+
+}  // namespace zobrist_detail
+
+constexpr Key pieceKey(PieceCode piece, Square square) { return zobrist_detail::KEYS.pieces[piece][square]; }
+constexpr Key castlingKey(std::uint8_t rights) { return zobrist_detail::KEYS.castling[rights]; }
+constexpr Key enPassantKey(Square square) { return zobrist_detail::KEYS.enPassant[fileOf(square)]; }
+constexpr Key sideKey() { return zobrist_detail::KEYS.side; }
+
+#endif //_ZOBRIST_H_
@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+#include "evaluate.h"
+#include "movegen.h"
+#include "nnue.h"
+#include "position.h"
+#include "search.h"
+#include "search_pool.h"
+#include "tt.h"
+
+// Time to reach a fixed depth on a handful of middlegame positions with
+// 1, 2, 4, 8 and 16 Lazy SMP threads. Each run starts from an empty
+// transposition table; the pool for a thread count is built once and
+// reused for every position, as the server does.
+//
+// Usage: bench [--depth N] [--hash-mb N] [--threads N] [--eval] [--eval-net FILE]
+//              [--latency MS]
+//   --threads   runs that single thread count instead of the series.
+//   --eval      measures incremental evaluations per second with each SIMD
+//               kernel the CPU supports instead of searching.
+//   --eval-net  evaluates with this network instead of the tables.
+//   --latency   lets the engine play itself from each position with MS
+//               per move, and reports how long the moves really took.
+
+namespace {
+
+constexpr const char* POSITIONS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8",
+    "2r2rk1/1bqnbppp/p2ppn2/1p6/3NP3/1BN1BP2/PPPQ2PP/2KR3R w - - 0 14",
+};
+
+// Plays every legal move of every position and evaluates the result,
+// the way a search does: push, evaluate, pop.
+void benchEvaluation() {
+  for (int level = static_cast<int>(detectSimd()); level >= 0; --level) {
+    useSimd(static_cast<SimdLevel>(level));
+    Evaluator evaluator;
+    std::uint64_t evaluations = 0;
+    std::int64_t checksum = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < 20000; ++round) {
+      for (const char* fen : POSITIONS) {
+        Position position;
+        Position::fromFen(fen, position);
+        evaluator.reset(position);
+        MoveList moves;
+        generateLegalMoves(position, moves);
+        for (Move move : moves) {
+          UndoInfo undo;
+          position.makeMove(move, undo);
+          evaluator.push(position, move, undo);
+          checksum += evaluator.evaluate(position);
+          evaluator.pop();
+          position.unmakeMove(move, undo);
+          ++evaluations;
+        }
+      }
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << simdName(activeSimd()) << "  " << static_cast<std::uint64_t>(evaluations / std::max(seconds, 1e-9))
+              << " evals/s  (checksum " << checksum << ")\n";
+  }
+}
+
+// Wall time of every move, searched the way the server does it: one
+// pool, one table that is aged rather than cleared between moves.
+void benchLatency(TranspositionTable& table, std::size_t threads, std::chrono::milliseconds moveTime) {
+  constexpr int kPlies = 40;
+  SearchPool pool(table, threads);
+  SearchLimits limits;
+  limits.moveTime = moveTime;
+  std::vector<double> milliseconds;
+  for (const char* fen : POSITIONS) {
+    Position position;
+    Position::fromFen(fen, position);
+    table.clear();
+    for (int ply = 0; ply < kPlies; ++ply) {
+      const auto start = std::chrono::steady_clock::now();
+      const SearchResult result = pool.search(position, limits);
+      milliseconds.push_back(
+          std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+      if (result.best.isNull())
+        break;
+      UndoInfo undo;
+      position.makeMove(result.best, undo);
+    }
+  }
+
+  std::sort(milliseconds.begin(), milliseconds.end());
+  auto percentile = [&milliseconds](std::size_t percent) {
+    return milliseconds[std::min(milliseconds.size() - 1, milliseconds.size() * percent / 100)];
+  };
+  std::cout << "threads " << threads << "  budget " << moveTime.count() << " ms  moves " << milliseconds.size()
+            << "  p50 " << percentile(50) << " ms  p99 " << percentile(99) << " ms  max " << milliseconds.back()
+            << " ms\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int depth = 9;
+  std::size_t hashMegabytes = 64;
+  std::vector<std::size_t> threadCounts = {1, 2, 4, 8, 16};
+  bool evaluationOnly = false;
+  std::chrono::milliseconds latencyBudget{0};
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "--depth" && i + 1 < argc) {
+      depth = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--hash-mb" && i + 1 < argc) {
+      hashMegabytes = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--threads" && i + 1 < argc) {
+      threadCounts = {static_cast<std::size_t>(std::max(1, std::atoi(argv[++i])))};
+    } else if (arg == "--latency" && i + 1 < argc) {
+      latencyBudget = std::chrono::milliseconds(std::max(1, std::atoi(argv[++i])));
+    } else if (arg == "--eval") {
+      evaluationOnly = true;
+    } else if (arg == "--eval-net" && i + 1 < argc) {
+      if (!loadNetwork(argv[++i])) {
+        std::cerr << "Error : cannot load network " << argv[i] << "\n";
+        return EXIT_FAILURE;
+      }
+    } else {
+      std::cerr << "Usage: bench [--depth N] [--hash-mb N] [--threads N] [--eval] [--eval-net FILE]"
+                   " [--latency MS]\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (evaluationOnly) {
+    benchEvaluation();
+    return EXIT_SUCCESS;
+  }
+
+  TranspositionTable table(hashMegabytes);
+  if (latencyBudget.count() > 0) {
+    for (const std::size_t threads : threadCounts)
+      benchLatency(table, threads, latencyBudget);
+    return EXIT_SUCCESS;
+  }
+
+  double baseline = 0;
+  for (const std::size_t threads : threadCounts) {
+    SearchPool pool(table, threads);
+    double seconds = 0;
+    std::uint64_t nodes = 0;
+    for (const char* fen : POSITIONS) {
+      Position position;
+      Position::fromFen(fen, position);
+      table.clear();
+      const auto start = std::chrono::steady_clock::now();
+      const SearchResult result = pool.search(position, {depth, std::chrono::hours(1)});
+      seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      nodes += result.nodes;
+    }
+    if (baseline == 0)
+      baseline = seconds;
+    std::cout << "threads " << threads << "  depth " << depth << "  time " << static_cast<int>(seconds * 1000)
+              << " ms  " << static_cast<std::uint64_t>(nodes / std::max(seconds, 1e-9)) << " nps  speedup "
+              << baseline / std::max(seconds, 1e-9) << "\n";
+  }
+  return EXIT_SUCCESS;
+}
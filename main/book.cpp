@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "book.h"
+#include "game.h"
+#include "position.h"
+#include "protocol.h"
+
+// Builds an opening book from a text file with one game or line per row,
+// written as UCI moves from the start position ("e2e4 e7e5 g1f3 ...").
+// Every position reached in the first N plies records the move played
+// from it; a move's weight is the number of rows that play it. '#' starts
+// a comment.
+//
+// Usage: book <openings.txt> <book.bin> [--plies N]
+
+namespace {
+
+bool parseUci(const Position& position, const std::string& text, Move& move) {
+  if (text.size() < 4 || text.size() > 5)
+    return false;
+  const int fromFile = text[0] - 'a', fromRank = text[1] - '1';
+  const int toFile = text[2] - 'a', toRank = text[3] - '1';
+  if (fromFile < 0 || fromFile > 7 || fromRank < 0 || fromRank > 7 || toFile < 0 || toFile > 7 || toRank < 0 ||
+      toRank > 7)
+    return false;
+
+  std::uint8_t promotion = NO_PROMOTION;
+  if (text.size() == 5) {
+    const std::string pieces = "kqrbnp";
+    const auto type = pieces.find(text[4]);
+    if (type == std::string::npos)
+      return false;
+    promotion = static_cast<std::uint8_t>(type);
+  }
+  move = moveFromWire(position, static_cast<std::uint8_t>(fromRank * 8 + fromFile),
+                      static_cast<std::uint8_t>(toRank * 8 + toFile), promotion);
+  return true;
+}
+
+void writeBigEndian(std::ostream& out, std::uint64_t value, int size) {
+  for (int i = size - 1; i >= 0; --i)
+    out.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  if (argc != 3 && !(argc == 5 && std::string(argv[3]) == "--plies")) {
+    std::cerr << "Usage: book <openings.txt> <book.bin> [--plies N]\n";
+    return EXIT_FAILURE;
+  }
+  const int maxPlies = argc == 5 ? std::max(1, std::atoi(argv[4])) : 16;
+
+  std::ifstream in(argv[1]);
+  if (!in) {
+    std::cerr << "Error : cannot read " << argv[1] << "\n";
+    return EXIT_FAILURE;
+  }
+
+  std::map<std::pair<Key, std::uint16_t>, std::uint32_t> counts;
+  std::string line;
+  int lineNumber = 0;
+  while (std::getline(in, line)) {
+    ++lineNumber;
+    line = line.substr(0, line.find('#'));
+    std::istringstream moves(line);
+    Position position = Position::startPosition();
+    std::string text;
+    for (int ply = 0; ply < maxPlies && moves >> text; ++ply) {
+      Move move;
+      if (!parseUci(position, text, move) || !isMoveLegal(position, move)) {
+        std::cerr << argv[1] << ":" << lineNumber << ": illegal move " << text << "\n";
+        return EXIT_FAILURE;
+      }
+      ++counts[{position.key(), toBookMove(move)}];
+      UndoInfo undo;
+      position.makeMove(move, undo);
+    }
+  }
+
+  std::ofstream out(argv[2], std::ios::binary);
+  for (const auto& [entry, count] : counts) {
+    writeBigEndian(out, entry.first, 8);
+    writeBigEndian(out, entry.second, 2);
+    writeBigEndian(out, std::min<std::uint32_t>(count, 0xFFFF), 2);
+    writeBigEndian(out, 0, 4);
+  }
+  if (!out) {
+    std::cerr << "Error : cannot write " << argv[2] << "\n";
+    return EXIT_FAILURE;
+  }
+  std::cout << counts.size() << " entries\n";
+  return EXIT_SUCCESS;
+}
@@ -10,10 +10,16 @@
 #include <SFML/Graphics/CircleShape.hpp>
 #include <SFML/System/Vector2.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <string_view>
 #include <vector>
 
+#include "attacks.h"
 #include "const.h"
+#include "framing.h"
+#include "protocol.h"
 #include "SFML/Graphics/Sprite.hpp"
 #include "SFML/Graphics/Texture.hpp"
 
@@ -21,14 +27,6 @@ enum class Status {
   NOT_CONNECTED,
   CONNECTED
 };
-enum class Color {
-  kWhite,
-  kBlack,
-  kNuLL
-};
-
-enum class PieceType { King, Queen, Rook, Bishop, Knight, Pawn };
-
 struct Piece {
   PieceType type;
   Color color;
@@ -36,14 +34,22 @@ struct Piece {
   sf::Sprite sprite;
 };
 
-bool isOccupied(const sf::Vector2i& pos, const std::vector<Piece>& pieces) {
+Bitboard occupancyOf(const std::vector<Piece>& pieces) {
+  Bitboard occupied = 0;
   for (const auto& piece : pieces) {
-    if (piece.pos == pos)
-      return true;
+    occupied |= squareBit(squareFromXY(piece.pos.x, piece.pos.y));
   }
-  return false;
+  return occupied;
 }
 
+std::vector<sf::Vector2i> toPositions(Bitboard targets) {
+  std::vector<sf::Vector2i> moves;
+  while (targets) {
+    const Square square = popLsb(targets);
+    moves.emplace_back(squareX(square), squareY(square));
+  }
+  return moves;
+}
 
 void MovePiece(std::vector<Piece>& pieces, sf::Vector2i current_pos, sf::Vector2i new_pos) {
   for (auto& piece : pieces) {
@@ -62,174 +68,78 @@ void RemovePiece(std::vector<Piece>& pieces, sf::Vector2i pos) {
   );
 }
 
+// Move hints come straight from the shared attack tables: own pieces are
+// masked out of the piece's attack set.
 std::vector<sf::Vector2i> getPawnMoves(const Piece& pawn,
                                        const std::vector<Piece>& whitePieces,
                                        const std::vector<Piece>& blackPieces) {
-  std::vector<sf::Vector2i> moves;
-  int direction = (pawn.color == Color::kWhite) ? -1 : 1;
-
-
-  sf::Vector2i forward = {pawn.pos.x, pawn.pos.y + direction};
-  if (forward.y >= 0 && forward.y < 8 &&
-      !isOccupied(forward, whitePieces) && !isOccupied(forward, blackPieces)) {
-    moves.push_back(forward);
-
-    if ((pawn.color == Color::kWhite && pawn.pos.y == 6) ||
-        (pawn.color == Color::kBlack && pawn.pos.y == 1)) {
-      sf::Vector2i doubleForward = {pawn.pos.x, pawn.pos.y + 2 * direction};
-      if (!isOccupied(doubleForward, whitePieces) && !isOccupied(doubleForward, blackPieces)) {
-        moves.push_back(doubleForward);
-      }
-    }
-  }
-
-
-  sf::Vector2i diagLeft = {pawn.pos.x - 1, pawn.pos.y + direction};
-  if (diagLeft.x >= 0 && diagLeft.x < 8 && diagLeft.y >= 0 && diagLeft.y < 8 &&
-      isOccupied(diagLeft, (pawn.color == Color::kWhite ? blackPieces : whitePieces))) {
-    moves.push_back(diagLeft);
-  }
-
-
-  sf::Vector2i diagRight = {pawn.pos.x + 1, pawn.pos.y + direction};
-  if (diagRight.x >= 0 && diagRight.x < 8 && diagRight.y >= 0 && diagRight.y < 8 &&
-      isOccupied(diagRight, (pawn.color == Color::kWhite ? blackPieces : whitePieces))) {
-    moves.push_back(diagRight);
-  }
-
-  return moves;
+  const Bitboard enemy = occupancyOf(pawn.color == Color::kWhite ? blackPieces : whitePieces);
+  const Bitboard empty = ~(occupancyOf(whitePieces) | occupancyOf(blackPieces));
+  const Square square = squareFromXY(pawn.pos.x, pawn.pos.y);
+
+  const Bitboard single = pawnPush(pawn.color, squareBit(square)) & empty;
+  const Bitboard doubleRank = pawn.color == Color::kWhite ? RANK_4 : RANK_5;
+  const Bitboard pushes = single | (pawnPush(pawn.color, single) & empty & doubleRank);
+  return toPositions(pushes | (pawnAttacks(pawn.color, square) & enemy));
 }
 
 
 std::vector<sf::Vector2i> getKnightMoves(const Piece& knight,
                                          const std::vector<Piece>& whitePieces,
                                          const std::vector<Piece>& blackPieces) {
-  std::vector<sf::Vector2i> moves;
-
-  const std::vector<Piece>& ownPieces = (knight.color == Color::kWhite ? whitePieces : blackPieces);
-
-
-  int offsets[8][2] = { {2, 1}, {2, -1}, {-2, 1}, {-2, -1},
-                        {1, 2}, {1, -2}, {-1, 2}, {-1, -2} };
-
-  for (int i = 0; i < 8; ++i) {
-    sf::Vector2i newPos = { knight.pos.x + offsets[i][0], knight.pos.y + offsets[i][1] };
-    if (newPos.x >= 0 && newPos.x < 8 && newPos.y >= 0 && newPos.y < 8) {
-
-      if (!isOccupied(newPos, ownPieces))
-        moves.push_back(newPos);
-    }
-  }
-  return moves;
+  const Bitboard own = occupancyOf(knight.color == Color::kWhite ? whitePieces : blackPieces);
+  return toPositions(knightAttacks(squareFromXY(knight.pos.x, knight.pos.y)) & ~own);
 }
 
 
 std::vector<sf::Vector2i> getBishopMoves(const Piece& bishop,
                                          const std::vector<Piece>& whitePieces,
                                          const std::vector<Piece>& blackPieces) {
-  std::vector<sf::Vector2i> moves;
-  const std::vector<Piece>& ownPieces = (bishop.color == Color::kWhite ? whitePieces : blackPieces);
-  const std::vector<Piece>& enemyPieces = (bishop.color == Color::kWhite ? blackPieces : whitePieces);
-
-
-  int directions[4][2] = { {1, 1}, {1, -1}, {-1, 1}, {-1, -1} };
-  for (int i = 0; i < 4; ++i) {
-    int dx = directions[i][0];
-    int dy = directions[i][1];
-    sf::Vector2i pos = bishop.pos;
-
-    while (true) {
-      pos.x += dx;
-      pos.y += dy;
-      if (pos.x < 0 || pos.x >= 8 || pos.y < 0 || pos.y >= 8)
-        break;
-      if (isOccupied(pos, ownPieces))
-        break;
-      moves.push_back(pos);
-      if (isOccupied(pos, enemyPieces))
-        break;
-    }
-  }
-  return moves;
+  const Bitboard own = occupancyOf(bishop.color == Color::kWhite ? whitePieces : blackPieces);
+  const Bitboard occupied = occupancyOf(whitePieces) | occupancyOf(blackPieces);
+  return toPositions(bishopAttacks(squareFromXY(bishop.pos.x, bishop.pos.y), occupied) & ~own);
 }
 
 std::vector<sf::Vector2i> getRookMoves(const Piece& rook,
                                        const std::vector<Piece>& whitePieces,
                                        const std::vector<Piece>& blackPieces) {
-  std::vector<sf::Vector2i> moves;
-  const std::vector<Piece>& ownPieces = (rook.color == Color::kWhite ? whitePieces : blackPieces);
-  const std::vector<Piece>& enemyPieces = (rook.color == Color::kWhite ? blackPieces : whitePieces);
-
-
-  int directions[4][2] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1} };
-  for (int i = 0; i < 4; ++i) {
-    int dx = directions[i][0];
-    int dy = directions[i][1];
-    sf::Vector2i pos = rook.pos;
-    while (true) {
-      pos.x += dx;
-      pos.y += dy;
-      if (pos.x < 0 || pos.x >= 8 || pos.y < 0 || pos.y >= 8)
-        break;
-      if (isOccupied(pos, ownPieces))
-        break;
-      moves.push_back(pos);
-      if (isOccupied(pos, enemyPieces))
-        break;
-    }
-  }
-  return moves;
+  const Bitboard own = occupancyOf(rook.color == Color::kWhite ? whitePieces : blackPieces);
+  const Bitboard occupied = occupancyOf(whitePieces) | occupancyOf(blackPieces);
+  return toPositions(rookAttacks(squareFromXY(rook.pos.x, rook.pos.y), occupied) & ~own);
 }
 
 
 std::vector<sf::Vector2i> getQueenMoves(const Piece& queen,
                                         const std::vector<Piece>& whitePieces,
                                         const std::vector<Piece>& blackPieces) {
-  std::vector<sf::Vector2i> moves;
-  const std::vector<Piece>& ownPieces = (queen.color == Color::kWhite ? whitePieces : blackPieces);
-  const std::vector<Piece>& enemyPieces = (queen.color == Color::kWhite ? blackPieces : whitePieces);
-
-
-  int directions[8][2] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1},
-                           {1, 1}, {1, -1}, {-1, 1}, {-1, -1} };
-  for (int i = 0; i < 8; ++i) {
-    int dx = directions[i][0];
-    int dy = directions[i][1];
-    sf::Vector2i pos = queen.pos;
-    while (true) {
-      pos.x += dx;
-      pos.y += dy;
-      if (pos.x < 0 || pos.x >= 8 || pos.y < 0 || pos.y >= 8)
-        break;
-      if (isOccupied(pos, ownPieces))
-        break;
-      moves.push_back(pos);
-      if (isOccupied(pos, enemyPieces))
-        break;
-    }
-  }
-  return moves;
+  const Bitboard own = occupancyOf(queen.color == Color::kWhite ? whitePieces : blackPieces);
+  const Bitboard occupied = occupancyOf(whitePieces) | occupancyOf(blackPieces);
+  return toPositions(queenAttacks(squareFromXY(queen.pos.x, queen.pos.y), occupied) & ~own);
 }
 std::vector<sf::Vector2i> getKingMoves(const Piece& king,
                                        const std::vector<Piece>& whitePieces,
                                        const std::vector<Piece>& blackPieces) {
-  std::vector<sf::Vector2i> moves;
-  const std::vector<Piece>& ownPieces = (king.color == Color::kWhite ? whitePieces : blackPieces);
-
-
-  for (int dx = -1; dx <= 1; ++dx) {
-    for (int dy = -1; dy <= 1; ++dy) {
-      if (dx == 0 && dy == 0)
-        continue;
-      sf::Vector2i newPos = { king.pos.x + dx, king.pos.y + dy };
-      if (newPos.x >= 0 && newPos.x < 8 && newPos.y >= 0 && newPos.y < 8) {
-        if (!isOccupied(newPos, ownPieces))
-          moves.push_back(newPos);
-      }
+  const Bitboard own = occupancyOf(king.color == Color::kWhite ? whitePieces : blackPieces);
+  return toPositions(kingAttacks(squareFromXY(king.pos.x, king.pos.y)) & ~own);
+}
+bool SendFrame(sf::TcpSocket &socket, std::string_view payload) {
+  std::string frame;
+  if (!appendFrame(frame, payload))
+    return false;
+
+  std::size_t offset = 0;
+  while (offset < frame.size()) {
+    std::size_t sent = 0;
+    const auto sendStatus = socket.send(frame.data() + offset, frame.size() - offset, sent);
+    offset += sent;
+    if (sendStatus != sf::Socket::Status::Done && sendStatus != sf::Socket::Status::Partial &&
+        sendStatus != sf::Socket::Status::NotReady) {
+      return false;
     }
   }
-  return moves;
+  return true;
 }
+
 void DrawPieces(sf::RenderWindow &window, const std::vector<Piece> &pieces, float tile_size) {
   for (const auto &piece : pieces) {
 
@@ -260,6 +170,7 @@ int main() {
   std::vector<std::string> receivedMessages;
   bool winner_PA = false;
   bool winner_PB = false;
+  bool stalemate = false;
 
 
   sf::TcpSocket socket;
@@ -269,9 +180,11 @@ int main() {
   short portNumber = PORT_NUMBER;
   std::string sendMessage;
   sendMessage.resize(MAX_MESSAGE_LENGTH, 0);
-  std::string receivedMessage;
-  receivedMessage.resize(MAX_MESSAGE_LENGTH, 0);
+  FrameBuffer receiveBuffer;
   bool firstIT = true;
+  int roomId = 0;
+  bool playBot = false;
+  bool joinSent = false;
 
   //-------------------------------------------------------------------
 
@@ -356,11 +269,21 @@ int main() {
   sf::Sprite knights_b(knights_texture_b);
   knights_b.setScale(sf::Vector2f (2.5,2.5));
 
+  auto promotionSprite = [&](Color color, PieceType type) -> const sf::Sprite & {
+    const bool white = color == Color::kWhite;
+    switch (type) {
+      case PieceType::Rook: return white ? rooks_w : rooks_b;
+      case PieceType::Bishop: return white ? bishops_w : bishops_b;
+      case PieceType::Knight: return white ? knights_w : knights_b;
+      default: return white ? queen_w : queen_b;
+    }
+  };
+
   std::vector<Piece> whitePieces;
   std::vector<Piece> blackPieces;
 
-  Color local_player = Color::kNuLL;
-  std::vector<Piece> *currentPiecesPlayer1;
+  Color local_player = Color::kNone;
+  std::vector<Piece> *currentPiecesPlayer1 = nullptr;
   std::vector<Piece> *currentPiecesPlayer2;
 
   whitePieces.push_back({PieceType::Rook,   Color::kWhite, sf::Vector2i(0, 7), rooks_w});
@@ -447,7 +370,8 @@ int main() {
         }
       }
 
-      if (sf::Mouse::isButtonPressed(sf::Mouse::Button::Left)) {
+      // Spectators (and clients still waiting for their role) only watch.
+      if (currentPiecesPlayer1 != nullptr && sf::Mouse::isButtonPressed(sf::Mouse::Button::Left)) {
         mousePos = static_cast<sf::Vector2f>(sf::Mouse::getPosition(window));
         selectedTileCoords = sf::Vector2i(floor(static_cast<int>(mousePos.x) / tile_size),
                                           floor(static_cast<int>(mousePos.y) / tile_size));
@@ -485,19 +409,15 @@ int main() {
                   //std::cout << "Déplacement demandé !" << std::endl;
 
 
-                  std::ostringstream messageStream;
-                  messageStream << "MOVE|"
-                                << static_cast<int>(piece.type) << "|"
-                                << piece.pos.x << "," << piece.pos.y << "|"
-                                << selectedTileCoords.x << "," << selectedTileCoords.y;
+                  MoveRecord move;
+                  move.piece = static_cast<std::uint8_t>(piece.type);
+                  move.from = toWireSquare(piece.pos.x, piece.pos.y);
+                  move.to = toWireSquare(selectedTileCoords.x, selectedTileCoords.y);
+                  const auto message = encodeMove(move);
 
-                  std::string message = messageStream.str();
 
-
-                  if (socket.send(message.c_str(), message.size()) != sf::Socket::Status::Done) {
+                  if (!SendFrame(socket, asPayload(message))) {
                     std::cerr << "Error" << std::endl;
-                  } else {
-                    std::cout <<  message << std::endl;
                   }
                   break;
                 }
@@ -548,130 +468,132 @@ int main() {
 
   if (status == Status::CONNECTED) {
 
-    std::string message;
-    //std::cout << "Message reçu : " << message << std::endl;
-    message.resize(MAX_MESSAGE_LENGTH, 0);
-    size_t actualLength;
-    sf::TcpSocket::Status receiveStatus = socket.receive(message.data(), MAX_MESSAGE_LENGTH, actualLength);
+    if (!joinSent) {
+      JoinRecord join;
+      join.room = static_cast<std::uint32_t>(roomId);
+      join.flags = playBot ? JOIN_FLAG_BOT : 0;
+      joinSent = SendFrame(socket, asPayload(encodeJoin(join)));
+    }
 
+    const std::span<char> free = receiveBuffer.writable();
+    size_t actualLength;
+    sf::TcpSocket::Status receiveStatus = socket.receive(free.data(), free.size(), actualLength);
     if (receiveStatus == sf::Socket::Status::Done) {
+      receiveBuffer.commit(actualLength);
+    }
 
-      if (message.find("ROLE") == 0) {
-        size_t separatorPos = message.find('|');
-        if (separatorPos != std::string::npos) {
-          std::string role = message.substr(separatorPos + 1);
-          if (role.find("PA") != std::string::npos) {
+    // A single read may carry several messages (e.g. MOVE + CAPTURE).
+    std::string_view payload;
+    while (receiveBuffer.nextFrame(payload) == FrameStatus::kReady) {
+      Opcode opcode;
+      if (!peekOpcode(payload, opcode))
+        continue;
+
+      switch (opcode) {
+        case Opcode::kRole: {
+          RoleRecord role;
+          if (!decodeRole(payload, role)) {
+            std::cerr << "mesage null" << std::endl;
+            break;
+          }
+          if (role.version != PROTOCOL_VERSION) {
+            std::cerr << "Protocol version mismatch: server " << static_cast<int>(role.version)
+                      << ", client " << static_cast<int>(PROTOCOL_VERSION) << std::endl;
+            break;
+          }
+          if (role.role == ROLE_PA) {
             local_player = Color::kWhite;
             currentPiecesPlayer1 = &whitePieces;
-            //std::cout << "Local player color: " << static_cast<int>(local_player) << std::endl;
-          }
-          else if (role.find("PB") != std::string::npos) {
+          } else if (role.role == ROLE_PB) {
             local_player = Color::kBlack;
             currentPiecesPlayer1 = &blackPieces;
-            //std::cout << "Local player color: " << static_cast<int>(local_player) << std::endl;
           }
-        } else {
-          std::cerr << "mesage null" << std::endl;
+          std::cout << "Joined room " << role.room << std::endl;
+          break;
         }
+        case Opcode::kMove: {
+          MoveRecord move;
+          if (!decodeMove(payload, move))
+            break;
 
-      }
-      if (message.find("MOVE") == 0) {
-        std::istringstream iss(message);
-        std::string token;
-
-
-        std::getline(iss, token, '|');  // token == "MOVE"
-
-
-        std::string role;
-        std::getline(iss, role, '|');
-
-
-        std::getline(iss, token, '|');
-        int pieceType = std::stoi(token);
-
-
-        std::getline(iss, token, '|');
-        size_t commaPos = token.find(',');
-        int oldX = std::stoi(token.substr(0, commaPos));
-        int oldY = std::stoi(token.substr(commaPos + 1));
-
-
-        std::getline(iss, token, '|');
-        commaPos = token.find(',');
-        int newX = std::stoi(token.substr(0, commaPos));
-        int newY = std::stoi(token.substr(commaPos + 1));
-
-//        std::cout << "Mouvement du joueur " << role
-//                  << " : pièce de type " << pieceType
-//                  << " de (" << oldX << ", " << oldY << ") vers ("
-//                  << newX << ", " << newY << ")" << std::endl;
-
+          const sf::Vector2i oldPos(wireSquareX(move.from), wireSquareY(move.from));
+          const sf::Vector2i newPos(wireSquareX(move.to), wireSquareY(move.to));
+          std::vector<Piece> *movedPieces = nullptr;
+          if (move.role == ROLE_PA) {
+            movedPieces = &whitePieces;
+          } else if (move.role == ROLE_PB) {
+            movedPieces = &blackPieces;
+          }
+          if (movedPieces == nullptr)
+            break;
 
-        if (role == "PA") {
-          MovePiece(whitePieces, sf::Vector2i(oldX, oldY), sf::Vector2i(newX, newY));
-        }
-        else if (role == "PB") {
-          MovePiece(blackPieces, sf::Vector2i(oldX, oldY), sf::Vector2i(newX, newY));
+          MovePiece(*movedPieces, oldPos, newPos);
+          if (move.promotion != NO_PROMOTION) {
+            for (auto &piece : *movedPieces) {
+              if (piece.pos == newPos) {
+                piece.type = static_cast<PieceType>(move.promotion);
+                piece.sprite = promotionSprite(piece.color, piece.type);
+                break;
+              }
+            }
+          }
+          break;
         }
-      }
-      if (message.find("CAPTURE") == 0) {
-
-        std::istringstream iss(message);
-        std::string token;
-
-
-        std::getline(iss, token, '|');
-
-
-        std::string capRole;
-        std::getline(iss, capRole, '|');
-
-
-        std::getline(iss, token, '|');
-        int capturedType = std::stoi(token);
-
-
-        std::getline(iss, token, '|');
-        size_t commaPos = token.find(',');
-        int capX = std::stoi(token.substr(0, commaPos));
-        int capY = std::stoi(token.substr(commaPos + 1));
-
-//        std::cout << "Capture d'une pièce de type " << capturedType
-//                  << " à la position (" << capX << ", " << capY << ") appartenant à "
-//                  << capRole << std::endl;
-
+        case Opcode::kCapture: {
+          CaptureRecord capture;
+          if (!decodeCapture(payload, capture))
+            break;
 
-        if (capRole == "PA") {
-          RemovePiece(whitePieces, sf::Vector2i(capX, capY));
-        } else if (capRole == "PB") {
-          RemovePiece(blackPieces, sf::Vector2i(capX, capY));
+          const sf::Vector2i capPos(wireSquareX(capture.square), wireSquareY(capture.square));
+          if (capture.role == ROLE_PA) {
+            RemovePiece(whitePieces, capPos);
+          } else if (capture.role == ROLE_PB) {
+            RemovePiece(blackPieces, capPos);
+          }
+          break;
         }
+        case Opcode::kCheckmate: {
+          CheckmateRecord checkmate;
+          if (!decodeCheckmate(payload, checkmate))
+            break;
 
-      }
-      if (message.find("CHECKMATE") == 0) {
-        std::istringstream iss(message);
-        std::string token;
-
-
-        std::getline(iss, token, '|');
-
-
-        std::string winnerRole;
-        std::getline(iss, winnerRole, '|');
-
-        std::cout << "Error : " << winnerRole << std::endl;
+          if (checkmate.winner == ROLE_PA) {
+            winner_PA = true;
+          } else if (checkmate.winner == ROLE_PB) {
+            winner_PB = true;
+          }
+          break;
+        }
+        case Opcode::kStalemate:
+          stalemate = decodeStalemate(payload);
+          break;
+        case Opcode::kHint: {
+          HintRecord hint;
+          if (!decodeHint(payload, hint))
+            break;
 
-        if (winnerRole == "PA") {
-          winner_PA = true;
-        } else if (winnerRole == "PB") {
-          winner_PB = true;
+          std::string text = hint.count == 0 ? "out of book" : "book:";
+          for (std::size_t i = 0; i < hint.count; ++i) {
+            const HintMove &move = hint.moves[i];
+            text += ' ';
+            text += static_cast<char>('a' + move.from % 8);
+            text += static_cast<char>('1' + move.from / 8);
+            text += static_cast<char>('a' + move.to % 8);
+            text += static_cast<char>('1' + move.to / 8);
+          }
+          receivedMessages.push_back(text);
+          break;
         }
+        default:
+          break;
       }
-
     }
     if (socket.getLocalPort() == 0) {
       status = Status::NOT_CONNECTED;
+      receiveBuffer = FrameBuffer();
+      joinSent = false;
+      local_player = Color::kNone;
+      currentPiecesPlayer1 = nullptr;
     }
 
   }
@@ -685,6 +607,8 @@ int main() {
       ImGui::InputText("Host Address", serverAddress.data(), serverAddress.size());
       ImGui::SameLine();
       ImGui::Text("%hd", portNumber);
+      ImGui::InputInt("Room", &roomId);
+      ImGui::Checkbox("Play the computer", &playBot);
       if (ImGui::Button("Connect")) {
         if (auto address = sf::IpAddress::resolve(serverAddress)) {
           socket.setBlocking(true);
@@ -709,11 +633,11 @@ int main() {
     case Status::CONNECTED: {
       ImGui::InputText("Message", sendMessage.data(), MAX_MESSAGE_LENGTH);
       if (ImGui::Button("Send")) {
-        size_t dataSent;
-        sf::TcpSocket::Status sendStatus;
-        do {
-          sendStatus = socket.send(sendMessage.data(), MAX_MESSAGE_LENGTH, dataSent);
-        } while (sendStatus == sf::Socket::Status::Partial);
+        SendFrame(socket, encodeChat(sendMessage.c_str()));
+      }
+      ImGui::SameLine();
+      if (ImGui::Button("Book moves")) {
+        SendFrame(socket, asPayload(encodeHintRequest()));
       }
       for (const auto &message : receivedMessages) {
         ImGui::Text("Received message: %s", message.data());
@@ -760,7 +684,7 @@ int main() {
   window.display();
   firstIT = false;
 
-    if (winner_PA || winner_PB) {
+    if (winner_PA || winner_PB || stalemate) {
       ImGui::PushStyleColor(ImGuiCol_WindowBg, ImVec4(0, 0, 0, 0));
       ImGui::SetNextWindowPos(ImVec2(window.getSize().x * 0.5f, window.getSize().y * 0.5f), ImGuiCond_Always, ImVec2(0.5f, 0.5f));
       ImGui::Begin("Overlay", nullptr,
@@ -772,6 +696,8 @@ int main() {
         ImGui::TextColored(ImVec4(1, 0, 0, 1), "Échec et mat ! Joueur 1 gagne !");
       else if (winner_PB)
         ImGui::TextColored(ImVec4(1, 0, 0, 1), "Échec et mat ! Joueur 2 gagne !");
+      else if (stalemate)
+        ImGui::TextColored(ImVec4(1, 1, 1, 1), "Pat ! Match nul.");
       else
         ImGui::TextColored(ImVec4(1, 1, 1, 1), "Échec et mat !");
 
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "movegen.h"
+#include "position.h"
+
+// Counts the leaves of the legal move tree to a fixed depth. Node counts
+// are compared against published values, so this doubles as a regression
+// test of the rules engine and as its throughput benchmark.
+//
+// Usage: perft [--depth N] [--threads N] [--divide] [--fen "<fen>"]
+//   Without --fen, runs the standard suite and checks every count.
+
+namespace {
+
+struct SuiteEntry {
+  const char* name;
+  const char* fen;
+  int depth;
+  std::uint64_t nodes;
+};
+
+// https://www.chessprogramming.org/Perft_Results
+constexpr SuiteEntry SUITE[] = {
+    {"start", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865609},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603},
+    {"position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, 674624},
+    {"position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4, 422333},
+    {"position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487},
+    {"position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, 3894594},
+};
+
+std::string toUci(Move move) {
+  std::string text = {static_cast<char>('a' + fileOf(move.from())), static_cast<char>('1' + rankOf(move.from())),
+                      static_cast<char>('a' + fileOf(move.to())), static_cast<char>('1' + rankOf(move.to()))};
+  if (move.kind() == MoveKind::kPromotion)
+    text += "kqrbnp"[static_cast<int>(move.promotion())];
+  return text;
+}
+
+// Leaves are counted from the size of the last generated list instead of
+// being played.
+std::uint64_t perft(Position& position, int depth) {
+  MoveList moves;
+  generateLegalMoves(position, moves);
+  if (depth <= 1)
+    return moves.size();
+
+  std::uint64_t nodes = 0;
+  for (Move move : moves) {
+    UndoInfo undo;
+    position.makeMove(move, undo);
+    nodes += perft(position, depth - 1);
+    position.unmakeMove(move, undo);
+  }
+  return nodes;
+}
+
+// Root moves are handed out to the threads one at a time; each thread
+// works on its own copy of the position.
+std::vector<std::uint64_t> perftRoot(const Position& root, const MoveList& moves, int depth, unsigned threadCount) {
+  std::vector<std::uint64_t> counts(moves.size(), 0);
+  std::atomic<std::size_t> next{0};
+
+  auto worker = [&]() {
+    Position position = root;
+    for (std::size_t i = next++; i < moves.size(); i = next++) {
+      UndoInfo undo;
+      position.makeMove(moves[i], undo);
+      counts[i] = depth > 1 ? perft(position, depth - 1) : 1;
+      position.unmakeMove(moves[i], undo);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned i = 1; i < threadCount; ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (auto& thread : threads)
+    thread.join();
+  return counts;
+}
+
+std::uint64_t run(const Position& root, int depth, unsigned threadCount, bool divide) {
+  const auto start = std::chrono::steady_clock::now();
+
+  MoveList moves;
+  generateLegalMoves(root, moves);
+  const std::vector<std::uint64_t> counts = perftRoot(root, moves, depth, threadCount);
+
+  std::uint64_t nodes = 0;
+  for (std::size_t i = 0; i < moves.size(); ++i) {
+    nodes += counts[i];
+    if (divide)
+      std::cout << "  " << toUci(moves[i]) << ": " << counts[i] << "\n";
+  }
+
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "  depth " << depth << "  nodes " << nodes << "  time " << static_cast<int>(seconds * 1000)
+            << " ms  " << static_cast<std::uint64_t>(nodes / std::max(seconds, 1e-9)) << " nps\n";
+  return nodes;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  int depth = 0;
+  unsigned threadCount = 1;
+  bool divide = false;
+  const char* fen = nullptr;
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "--depth" && i + 1 < argc) {
+      depth = std::atoi(argv[++i]);
+    } else if (arg == "--threads" && i + 1 < argc) {
+      threadCount = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+    } else if (arg == "--divide") {
+      divide = true;
+    } else if (arg == "--fen" && i + 1 < argc) {
+      fen = argv[++i];
+    } else {
+      std::cerr << "Usage: perft [--depth N] [--threads N] [--divide] [--fen \"<fen>\"]\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (fen) {
+    Position position;
+    if (!Position::fromFen(fen, position)) {
+      std::cerr << "Error : invalid FEN\n";
+      return EXIT_FAILURE;
+    }
+    std::cout << fen << "\n";
+    run(position, depth > 0 ? depth : 5, threadCount, divide);
+    return EXIT_SUCCESS;
+  }
+
+  // --depth on the suite only goes shallower; deeper counts are not listed.
+  bool passed = true;
+  for (const SuiteEntry& entry : SUITE) {
+    Position position;
+    Position::fromFen(entry.fen, position);
+    std::cout << entry.name << "\n";
+    const int entryDepth = depth > 0 ? std::min(depth, entry.depth) : entry.depth;
+    const std::uint64_t nodes = run(position, entryDepth, threadCount, divide);
+    if (entryDepth == entry.depth && nodes != entry.nodes) {
+      std::cout << "  FAILED: expected " << entry.nodes << "\n";
+      passed = false;
+    }
+  }
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,425 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "attacks.h"
+#include "game.h"
+#include "movegen.h"
+#include "position.h"
+#include "tablebase.h"
+
+// Builds endgame tablebases by retrograde analysis. Every position of a
+// table is set up once to count its moves and to look up captures and
+// promotions in the smaller tables they lead to. From the mates outwards,
+// ply by ply, the positions decided at the previous ply are then un-moved
+// into their predecessors: a predecessor that can reach a lost position is
+// won, and one whose every move reaches a won position is lost. Whatever
+// is left undecided at the end is a draw. Both passes are split across
+// threads.
+//
+// Usage: tbgen [--out DIR] [--threads N] [SIGNATURE...]
+//   Signatures are written like KQvKR (at most 5 pieces). The tables the
+//   captures and promotions lead to are built and written first. With no
+//   signature, every 3 piece table is built. Files go to data/tb by default.
+
+namespace {
+
+// Generation-time entry values on top of the file's 1 + plies encoding.
+constexpr std::uint8_t UNKNOWN = 255;
+constexpr std::uint8_t ILLEGAL = 254;
+// externalWin_ when no capture or promotion mates; externalLoss_ when one
+// of them draws, so the position can never be lost.
+constexpr std::uint8_t NO_WIN = 255;
+constexpr std::uint8_t DRAW_EXIT = 255;
+
+constexpr std::uint64_t CHUNK_ENTRIES = 1 << 16;
+
+constexpr const char* DEFAULT_TABLES[] = {"KQvK", "KRvK", "KBvK", "KNvK", "KPvK"};
+
+unsigned THREADS = std::max(1u, std::thread::hardware_concurrency());
+
+// Finished tables by material key, for the captures and promotions of the
+// tables built after them.
+std::map<std::uint64_t, std::vector<std::uint8_t>> TABLES;
+
+// Runs work(begin, end) over [0, count) in chunks handed out to every
+// thread; returns the sum of what the calls returned.
+template <typename Work>
+std::uint64_t parallelFor(std::uint64_t count, Work work) {
+  std::atomic<std::uint64_t> next{0};
+  std::atomic<std::uint64_t> total{0};
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < THREADS; ++i) {
+    threads.emplace_back([&] {
+      std::uint64_t sum = 0;
+      for (std::uint64_t begin = next.fetch_add(CHUNK_ENTRIES); begin < count;
+           begin = next.fetch_add(CHUNK_ENTRIES))
+        sum += work(begin, std::min(count, begin + CHUNK_ENTRIES));
+      total += sum;
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+  return total;
+}
+
+TablebaseResult probeBuilt(const Position& position) {
+  if (popCount(position.occupied()) == 2)
+    return {};
+  bool flipped;
+  const Material material = materialOf(position, flipped);
+  return tablebaseResult(TABLES.at(materialKey(material))[tablebaseIndex(material, position, flipped)]);
+}
+
+// Squares `piece` on `square` may have come from without capturing.
+Bitboard retractions(PieceCode piece, Square square, Bitboard occupied) {
+  switch (pieceType(piece)) {
+    case PieceType::King: return kingAttacks(square) & ~occupied;
+    case PieceType::Queen: return queenAttacks(square, occupied) & ~occupied;
+    case PieceType::Rook: return rookAttacks(square, occupied) & ~occupied;
+    case PieceType::Bishop: return bishopAttacks(square, occupied) & ~occupied;
+    case PieceType::Knight: return knightAttacks(square) & ~occupied;
+    case PieceType::Pawn: break;
+  }
+  const bool white = pieceColor(piece) == Color::kWhite;
+  const int back = white ? -8 : 8;
+  const int rank = white ? rankOf(square) : 7 - rankOf(square);
+  Bitboard from = 0;
+  if (rank >= 2 && !(occupied & squareBit(square + back))) {
+    from |= squareBit(square + back);
+    if (rank == 3 && !(occupied & squareBit(square + 2 * back)))
+      from |= squareBit(square + 2 * back);
+  }
+  return from;
+}
+
+class Generator {
+ public:
+  explicit Generator(const Material& material)
+      : material_(material),
+        entries_(tablebaseEntries(material)),
+        values_(entries_),
+        moves_(entries_),
+        externalWin_(entries_),
+        externalLoss_(entries_) {}
+
+  std::vector<std::uint8_t> run() {
+    parallelFor(entries_, [this](std::uint64_t begin, std::uint64_t end) { return initialize(begin, end); });
+    for (int ply = 1; ply <= TABLEBASE_MAX_DTM; ++ply) {
+      const std::uint64_t resolved =
+          parallelFor(entries_, [this, ply](std::uint64_t begin, std::uint64_t end) {
+            return resolveExternal(begin, end, ply);
+          }) +
+          parallelFor(entries_, [this, ply](std::uint64_t begin, std::uint64_t end) {
+            return propagate(begin, end, ply);
+          });
+      if (resolved == 0 && ply >= lastExternal_)
+        break;
+    }
+
+    // Positions that cannot occur are never probed; repeating the previous
+    // value there makes for longer runs.
+    std::vector<std::uint8_t> values(entries_);
+    std::uint8_t previous = TABLEBASE_DRAW;
+    for (std::uint64_t i = 0; i < entries_; ++i) {
+      const std::uint8_t value = values_[i].load(std::memory_order_relaxed);
+      values[i] = value == ILLEGAL ? previous : value == UNKNOWN ? TABLEBASE_DRAW : value;
+      previous = values[i];
+      if (value != ILLEGAL) {
+        const TablebaseResult result = tablebaseResult(values[i]);
+        won_ += result.wdl == Wdl::kWin;
+        lost_ += result.wdl == Wdl::kLoss;
+        longest_ = std::max(longest_, result.dtm);
+      }
+    }
+    return values;
+  }
+
+  std::uint64_t won() const { return won_; }
+  std::uint64_t lost() const { return lost_; }
+  int longest() const { return longest_; }
+
+ private:
+  Color decode(std::uint64_t index, std::array<Square, TABLEBASE_MAX_PIECES>& squares) const {
+    for (int i = 0; i < material_.count; ++i)
+      squares[i] = static_cast<Square>((index >> (6 * i)) & 63);
+    return static_cast<Color>(index >> (6 * material_.count));
+  }
+
+  std::uint64_t initialize(std::uint64_t begin, std::uint64_t end) {
+    std::uint64_t mates = 0;
+    int lastExternal = 0;
+    std::array<Square, TABLEBASE_MAX_PIECES> squares{};
+    for (std::uint64_t index = begin; index < end; ++index) {
+      values_[index].store(ILLEGAL, std::memory_order_relaxed);
+      const Color sideToMove = decode(index, squares);
+      bool pawnOnBackRank = false;
+      for (int i = 0; i < material_.count; ++i)
+        pawnOnBackRank |= pieceType(material_.pieces[i]) == PieceType::Pawn &&
+                          (rankOf(squares[i]) == 0 || rankOf(squares[i]) == 7);
+      Position position;
+      if (pawnOnBackRank ||
+          !Position::fromPieces({material_.pieces.data(), static_cast<std::size_t>(material_.count)},
+                                {squares.data(), static_cast<std::size_t>(material_.count)}, sideToMove,
+                                position) ||
+          isKingInCheck(position, opposite(sideToMove)))
+        continue;
+
+      MoveList moves;
+      generateLegalMoves(position, moves);
+      if (moves.empty()) {
+        const bool mated = isKingInCheck(position, sideToMove);
+        values_[index].store(mated ? 1 : UNKNOWN, std::memory_order_relaxed);
+        externalLoss_[index] = DRAW_EXIT;
+        mates += mated;
+        continue;
+      }
+
+      // Captures and promotions leave the table and are decided already.
+      int inside = 0;
+      int win = NO_WIN;
+      int loss = 0;
+      for (const Move move : moves) {
+        if (position.pieceOn(move.to()) == NO_PIECE && move.kind() != MoveKind::kPromotion) {
+          ++inside;
+          continue;
+        }
+        Position next = position;
+        UndoInfo undo;
+        next.makeMove(move, undo);
+        const TablebaseResult result = probeBuilt(next);
+        if (result.wdl == Wdl::kDraw || result.dtm + 1 > TABLEBASE_MAX_DTM)
+          loss = DRAW_EXIT;
+        else if (result.wdl == Wdl::kLoss)
+          win = std::min(win, result.dtm + 1);
+        else if (loss != DRAW_EXIT)
+          loss = std::max(loss, result.dtm + 1);
+      }
+      values_[index].store(UNKNOWN, std::memory_order_relaxed);
+      moves_[index].store(static_cast<std::uint8_t>(inside), std::memory_order_relaxed);
+      externalWin_[index] = static_cast<std::uint8_t>(win);
+      externalLoss_[index] = static_cast<std::uint8_t>(loss);
+      if (win != NO_WIN)
+        lastExternal = std::max(lastExternal, win);
+      if (loss != DRAW_EXIT)
+        lastExternal = std::max(lastExternal, loss);
+    }
+
+    int current = lastExternal_.load();
+    while (lastExternal > current && !lastExternal_.compare_exchange_weak(current, lastExternal)) {
+    }
+    return mates;
+  }
+
+  // Positions whose outcome at `ply` comes from a capture or promotion.
+  std::uint64_t resolveExternal(std::uint64_t begin, std::uint64_t end, int ply) {
+    std::uint64_t resolved = 0;
+    for (std::uint64_t index = begin; index < end; ++index) {
+      if (values_[index].load(std::memory_order_relaxed) != UNKNOWN)
+        continue;
+      if (externalWin_[index] == ply ||
+          (externalWin_[index] == NO_WIN && externalLoss_[index] == ply &&
+           moves_[index].load(std::memory_order_relaxed) == 0)) {
+        values_[index].store(static_cast<std::uint8_t>(ply + 1), std::memory_order_relaxed);
+        ++resolved;
+      }
+    }
+    return resolved;
+  }
+
+  // Un-moves every position decided at ply - 1 into its predecessors.
+  std::uint64_t propagate(std::uint64_t begin, std::uint64_t end, int ply) {
+    std::uint64_t resolved = 0;
+    const bool frontierLost = (ply - 1) % 2 == 0;
+    const std::uint64_t sideBit = std::uint64_t{1} << (6 * material_.count);
+    std::array<Square, TABLEBASE_MAX_PIECES> squares{};
+    for (std::uint64_t index = begin; index < end; ++index) {
+      if (values_[index].load(std::memory_order_relaxed) != ply)
+        continue;
+      const Color mover = opposite(decode(index, squares));
+      Bitboard occupied = 0;
+      for (int i = 0; i < material_.count; ++i)
+        occupied |= squareBit(squares[i]);
+
+      for (int i = 0; i < material_.count; ++i) {
+        if (pieceColor(material_.pieces[i]) != mover)
+          continue;
+        const int shift = 6 * i;
+        const std::uint64_t rest = (index ^ sideBit) & ~(std::uint64_t{63} << shift);
+        Bitboard from = retractions(material_.pieces[i], squares[i], occupied);
+        while (from) {
+          const std::uint64_t predecessor = rest | (static_cast<std::uint64_t>(popLsb(from)) << shift);
+          std::uint8_t expected = UNKNOWN;
+          if (values_[predecessor].load(std::memory_order_relaxed) != UNKNOWN)
+            continue;
+          if (frontierLost) {
+            resolved += values_[predecessor].compare_exchange_strong(expected, static_cast<std::uint8_t>(ply + 1),
+                                                                     std::memory_order_relaxed);
+          } else if (moves_[predecessor].fetch_sub(1, std::memory_order_relaxed) == 1 &&
+                     externalWin_[predecessor] == NO_WIN && externalLoss_[predecessor] <= ply) {
+            resolved += values_[predecessor].compare_exchange_strong(expected, static_cast<std::uint8_t>(ply + 1),
+                                                                     std::memory_order_relaxed);
+          }
+        }
+      }
+    }
+    return resolved;
+  }
+
+  Material material_;
+  std::uint64_t entries_;
+  std::vector<std::atomic<std::uint8_t>> values_;
+  // In-table moves not yet known to lose.
+  std::vector<std::atomic<std::uint8_t>> moves_;
+  // Shortest mate through a capture or promotion, and the longest defence
+  // when all of them lose.
+  std::vector<std::uint8_t> externalWin_;
+  std::vector<std::uint8_t> externalLoss_;
+  std::atomic<int> lastExternal_{0};
+  std::uint64_t won_ = 0;
+  std::uint64_t lost_ = 0;
+  int longest_ = 0;
+};
+
+template <typename T>
+void writeLittleEndian(std::ostream& out, T value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+bool writeTable(const std::filesystem::path& path, const Material& material, const std::vector<std::uint8_t>& values) {
+  const std::uint64_t blockCount = (values.size() + TABLEBASE_BLOCK_ENTRIES - 1) / TABLEBASE_BLOCK_ENTRIES;
+  std::vector<std::uint64_t> offsets;
+  std::string payload;
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    if (i % TABLEBASE_BLOCK_ENTRIES == 0)
+      offsets.push_back(payload.size());
+    const std::size_t blockEnd = std::min(values.size(), (i / TABLEBASE_BLOCK_ENTRIES + 1) * TABLEBASE_BLOCK_ENTRIES);
+    std::size_t run = 1;
+    while (i + run < blockEnd && run < 255 && values[i + run] == values[i])
+      ++run;
+    payload += static_cast<char>(run);
+    payload += static_cast<char>(values[i]);
+    i += run - 1;
+  }
+  offsets.push_back(payload.size());
+
+  std::ofstream out(path, std::ios::binary);
+  writeLittleEndian(out, TABLEBASE_MAGIC);
+  writeLittleEndian(out, TABLEBASE_VERSION);
+  writeLittleEndian(out, static_cast<std::uint32_t>(material.count));
+  writeLittleEndian(out, static_cast<std::uint32_t>(TABLEBASE_BLOCK_ENTRIES));
+  writeLittleEndian(out, blockCount);
+  std::array<std::uint8_t, 8> pieces{};
+  std::copy_n(material.pieces.begin(), material.count, pieces.begin());
+  out.write(reinterpret_cast<const char*>(pieces.data()), pieces.size());
+  for (const std::uint64_t offset : offsets)
+    writeLittleEndian(out, offset);
+  out.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+  return static_cast<bool>(out);
+}
+
+// Tables the captures and promotions of `material` lead to.
+std::vector<Material> successors(const Material& material) {
+  std::vector<Material> tables;
+  auto add = [&tables](const Material& changed) {
+    Material canonical;
+    if (changed.count > 2 && parseMaterial(materialName(changed), canonical))
+      tables.push_back(canonical);
+  };
+  for (int i = 0; i < material.count; ++i) {
+    const PieceType type = pieceType(material.pieces[i]);
+    if (type == PieceType::King)
+      continue;
+    Material captured;
+    for (int j = 0; j < material.count; ++j) {
+      if (j != i)
+        captured.pieces[captured.count++] = material.pieces[j];
+    }
+    add(captured);
+    if (type == PieceType::Pawn) {
+      for (const PieceType promotion : {PieceType::Queen, PieceType::Rook, PieceType::Bishop, PieceType::Knight}) {
+        Material promoted = material;
+        promoted.pieces[i] = makePiece(pieceColor(material.pieces[i]), promotion);
+        add(promoted);
+      }
+    }
+  }
+  return tables;
+}
+
+bool generate(const Material& material, const std::filesystem::path& directory) {
+  const std::uint64_t key = materialKey(material);
+  if (TABLES.contains(key))
+    return true;
+  for (const Material& successor : successors(material)) {
+    if (!generate(successor, directory))
+      return false;
+  }
+
+  const std::string name = materialName(material);
+  const std::uint64_t entries = tablebaseEntries(material);
+  std::cout << name << ": " << entries << " positions, about " << (entries * 5 >> 20) << " MB while building"
+            << std::endl;
+  const auto start = std::chrono::steady_clock::now();
+  Generator generator(material);
+  std::vector<std::uint8_t> values = generator.run();
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  const std::filesystem::path path = directory / (name + ".tb");
+  if (!writeTable(path, material, values)) {
+    std::cerr << "Error : cannot write " << path << "\n";
+    return false;
+  }
+  std::cout << "  " << generator.won() << " won, " << generator.lost() << " lost, longest mate " << generator.longest()
+            << " plies, "
+            << std::filesystem::file_size(path) << " bytes, " << elapsed.count() << " s" << std::endl;
+  TABLES[key] = std::move(values);
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  std::filesystem::path directory = "data/tb";
+  std::vector<Material> requested;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    Material material;
+    if (arg == "--out" && i + 1 < argc) {
+      directory = argv[++i];
+    } else if (arg == "--threads" && i + 1 < argc) {
+      THREADS = static_cast<unsigned>(std::max(1l, std::strtol(argv[++i], nullptr, 10)));
+    } else if (parseMaterial(arg, material) && material.count > 2) {
+      requested.push_back(material);
+    } else {
+      std::cerr << "Usage: tbgen [--out DIR] [--threads N] [SIGNATURE...]\n";
+      return EXIT_FAILURE;
+    }
+  }
+  if (requested.empty()) {
+    for (const char* name : DEFAULT_TABLES) {
+      Material material;
+      parseMaterial(name, material);
+      requested.push_back(material);
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::create_directories(directory, error);
+  for (const Material& material : requested) {
+    if (!generate(material, directory))
+      return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,142 @@
+#include "acceptor.h"
+
+#include <cerrno>
+#include <iostream>
+
+#include <sys/socket.h>
+
+#include "net.h"
+#include "protocol.h"
+
+namespace {
+
+// How often the waiting connections are checked against kJoinTimeout.
+constexpr std::chrono::milliseconds SWEEP_INTERVAL{1000};
+
+}  // namespace
+
+Acceptor::Acceptor(std::span<const std::unique_ptr<Shard>> shards) : shards_(shards) {}
+
+Acceptor::~Acceptor() {
+  for (const auto& [socket, pending] : pending_)
+    closeSocket(socket);
+  if (listener_ >= 0)
+    closeSocket(listener_);
+}
+
+bool Acceptor::listen(unsigned short port, bool reusePort) {
+  listener_ = listenTcp(port, reusePort);
+  return listener_ >= 0 && reactor_.isValid() && reactor_.add(listener_, EPOLLIN | EPOLLET);
+}
+
+void Acceptor::run() {
+  nextSweep_ = std::chrono::steady_clock::now() + SWEEP_INTERVAL;
+  while (true) {
+    // Only wakes up for the sweep while connections are waiting for JOIN.
+    const int timeout = pending_.empty() ? -1 : static_cast<int>(SWEEP_INTERVAL.count());
+    for (const epoll_event& event : reactor_.wait(timeout)) {
+      if (event.data.fd == listener_) {
+        acceptClients();
+        continue;
+      }
+      receiveFrom(event.data.fd);
+    }
+    if (std::chrono::steady_clock::now() >= nextSweep_) {
+      dropExpired();
+      nextSweep_ = std::chrono::steady_clock::now() + SWEEP_INTERVAL;
+    }
+  }
+}
+
+void Acceptor::acceptClients() {
+  // Edge-triggered: keep accepting until the backlog is empty.
+  while (true) {
+    const int socket = ::accept4(listener_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (socket < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+        std::cerr << "Error while accepting\n";
+      return;
+    }
+
+    if (pending_.size() >= kMaxPending) {
+      closeSocket(socket);
+      continue;
+    }
+    setNoDelay(socket);
+    if (!reactor_.add(socket, EPOLLIN | EPOLLRDHUP | EPOLLET)) {
+      closeSocket(socket);
+      continue;
+    }
+    pending_[socket] = Pending{std::make_unique<FrameBuffer>(), std::chrono::steady_clock::now()};
+  }
+}
+
+void Acceptor::receiveFrom(int socket) {
+  const auto it = pending_.find(socket);
+  if (it == pending_.end())
+    return;
+
+  FrameBuffer& buffer = *it->second.buffer;
+  while (true) {
+    const std::span<char> free = buffer.writable();
+    const ssize_t received = ::recv(socket, free.data(), free.size(), 0);
+    if (received > 0) {
+      buffer.commit(static_cast<std::size_t>(received));
+
+      std::string_view payload;
+      const FrameStatus frameStatus = buffer.nextFrame(payload);
+      if (frameStatus == FrameStatus::kReady) {
+        // The rest of the buffer follows the connection to its shard.
+        handOff(socket, payload);
+        return;
+      }
+      if (frameStatus == FrameStatus::kInvalid) {
+        dropPending(socket);
+        return;
+      }
+      continue;
+    }
+    if (received < 0 && errno == EINTR)
+      continue;
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return;
+    dropPending(socket);
+    return;
+  }
+}
+
+void Acceptor::handOff(int socket, std::string_view payload) {
+  JoinRecord join;
+  if (!decodeJoin(payload, join)) {
+    std::cerr << "Error : expected join\n";
+    dropPending(socket);
+    return;
+  }
+
+  reactor_.remove(socket);
+  Handoff handoff{socket, join.room, join.flags, std::move(pending_[socket].buffer)};
+  pending_.erase(socket);
+  if (!shards_[shardForRoom(join.room, shards_.size())]->post(std::move(handoff))) {
+    std::cerr << "Error : shard overloaded\n";
+    closeSocket(socket);
+  }
+}
+
+void Acceptor::dropPending(int socket) {
+  closeSocket(socket);
+  pending_.erase(socket);
+}
+
+void Acceptor::dropExpired() {
+  const auto deadline = std::chrono::steady_clock::now() - kJoinTimeout;
+  for (auto it = pending_.begin(); it != pending_.end();) {
+    if (it->second.accepted <= deadline) {
+      closeSocket(it->first);
+      it = pending_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
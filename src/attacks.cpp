@@ -0,0 +1,118 @@
+#include "attacks.h"
+
+namespace attacks_detail {
+
+std::array<Magic, 64> ROOK_MAGICS;
+std::array<Magic, 64> BISHOP_MAGICS;
+std::array<std::array<Bitboard, 64>, 64> BETWEEN;
+std::array<std::array<Bitboard, 64>, 64> LINE;
+
+}  // namespace attacks_detail
+
+namespace {
+
+using attacks_detail::Magic;
+
+std::array<Bitboard, 102400> rookTable;
+std::array<Bitboard, 5248> bishopTable;
+
+// xorshift64* -- deterministic, so the same magics are found on every run.
+class Random {
+ public:
+  explicit Random(std::uint64_t seed) : state_(seed) {}
+
+  std::uint64_t next() {
+    state_ ^= state_ >> 12;
+    state_ ^= state_ << 25;
+    state_ ^= state_ >> 27;
+    return state_ * 2685821657736338717ull;
+  }
+  // Magics with few bits set are found much faster.
+  std::uint64_t sparse() { return next() & next() & next(); }
+
+ private:
+  std::uint64_t state_;
+};
+
+Bitboard boardEdges(Square square) {
+  const Bitboard rank = RANK_1 << (8 * rankOf(square));
+  const Bitboard file = FILE_A << fileOf(square);
+  return ((RANK_1 | RANK_8) & ~rank) | ((FILE_A | FILE_H) & ~file);
+}
+
+template <typename Slide>
+void initMagics(std::array<Magic, 64>& magics, Bitboard* table, Slide slide) {
+  static constexpr std::array<std::uint64_t, 8> seeds = {728, 10316, 55013, 32803, 12281, 15100, 16645, 255};
+
+  std::array<Bitboard, 4096> occupancy{};
+  std::array<Bitboard, 4096> reference{};
+  std::array<int, 4096> epoch{};
+  int attempt = 0;
+
+  for (Square square = 0; square < 64; ++square) {
+    Magic& magic = magics[square];
+    magic.mask = slide(squareBit(square), 0) & ~boardEdges(square);
+    magic.shift = 64 - popCount(magic.mask);
+    magic.attacks = table;
+
+    // Carry-Rippler walk over every subset of the mask.
+    std::size_t size = 0;
+    Bitboard subset = 0;
+    do {
+      occupancy[size] = subset;
+      reference[size] = slide(squareBit(square), subset);
+      ++size;
+      subset = (subset - magic.mask) & magic.mask;
+    } while (subset);
+
+#if defined(__BMI2__)
+    for (std::size_t i = 0; i < size; ++i)
+      table[magic.index(occupancy[i])] = reference[i];
+#else
+    Random random(seeds[rankOf(square)]);
+    for (std::size_t i = 0; i < size;) {
+      do {
+        magic.magic = random.sparse();
+      } while (popCount((magic.magic * magic.mask) >> 56) < 6);
+
+      // A magic is good when no two subsets with different attacks collide.
+      ++attempt;
+      for (i = 0; i < size; ++i) {
+        const std::size_t index = magic.index(occupancy[i]);
+        if (epoch[index] < attempt) {
+          epoch[index] = attempt;
+          table[index] = reference[i];
+        } else if (table[index] != reference[i]) {
+          break;
+        }
+      }
+    }
+#endif
+    table += size;
+  }
+}
+
+void initLines() {
+  for (Square a = 0; a < 64; ++a) {
+    for (Square b = 0; b < 64; ++b) {
+      const Bitboard ends = squareBit(a) | squareBit(b);
+      if (a != b && (rookAttacks(a, 0) & squareBit(b))) {
+        attacks_detail::LINE[a][b] = (rookAttacks(a, 0) & rookAttacks(b, 0)) | ends;
+        attacks_detail::BETWEEN[a][b] = rookAttacks(a, squareBit(b)) & rookAttacks(b, squareBit(a));
+      } else if (a != b && (bishopAttacks(a, 0) & squareBit(b))) {
+        attacks_detail::LINE[a][b] = (bishopAttacks(a, 0) & bishopAttacks(b, 0)) | ends;
+        attacks_detail::BETWEEN[a][b] = bishopAttacks(a, squareBit(b)) & bishopAttacks(b, squareBit(a));
+      }
+    }
+  }
+}
+
+// Runs during static initialization of the chess library, before main().
+const bool magicsReady = [] {
+  initMagics(attacks_detail::ROOK_MAGICS, rookTable.data(), rookAttackSet);
+  initMagics(attacks_detail::BISHOP_MAGICS, bishopTable.data(), bishopAttackSet);
+  initLines();
+  return true;
+}();
+
+}  // namespace
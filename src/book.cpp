@@ -0,0 +1,141 @@
+#include "book.h"
+
+#include <algorithm>
+#include <array>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "game.h"
+#include "movegen.h"
+
+namespace {
+
+constexpr std::size_t MAX_BOOK_MOVES = 32;
+
+std::uint64_t readBigEndian(const unsigned char* bytes, std::size_t size) {
+  std::uint64_t value = 0;
+  for (std::size_t i = 0; i < size; ++i)
+    value = (value << 8) | bytes[i];
+  return value;
+}
+
+// Promotion codes 1..4 are knight, bishop, rook, queen.
+constexpr PieceType BOOK_PROMOTIONS[] = {PieceType::Queen, PieceType::Knight, PieceType::Bishop, PieceType::Rook,
+                                         PieceType::Queen};
+
+Move fromBookMove(const Position& position, std::uint16_t raw) {
+  const Square to = raw & 0x3F;
+  const Square from = (raw >> 6) & 0x3F;
+  const int promotion = (raw >> 12) & 7;
+
+  // King takes own rook: castling, which this engine writes as the king's
+  // two square move.
+  const PieceCode piece = position.pieceOn(from);
+  if (pieceType(piece) == PieceType::King && position.pieceOn(to) == makePiece(pieceColor(piece), PieceType::Rook))
+    return Move(from, to > from ? from + 2 : from - 2, MoveKind::kCastling);
+  if (promotion > 0 && promotion <= 4)
+    return Move(from, to, MoveKind::kPromotion, BOOK_PROMOTIONS[promotion]);
+  return moveFromWire(position, static_cast<std::uint8_t>(from), static_cast<std::uint8_t>(to), 0xFF);
+}
+
+}  // namespace
+
+std::uint16_t toBookMove(Move move) {
+  Square to = move.to();
+  if (move.kind() == MoveKind::kCastling)
+    to = castlingRookFrom(to);
+  int promotion = 0;
+  if (move.kind() == MoveKind::kPromotion) {
+    switch (move.promotion()) {
+      case PieceType::Knight: promotion = 1; break;
+      case PieceType::Bishop: promotion = 2; break;
+      case PieceType::Rook: promotion = 3; break;
+      default: promotion = 4; break;
+    }
+  }
+  return static_cast<std::uint16_t>(to | (move.from() << 6) | (promotion << 12));
+}
+
+OpeningBook::~OpeningBook() {
+  if (records_)
+    ::munmap(const_cast<unsigned char*>(records_), count_ * BOOK_RECORD_SIZE);
+}
+
+bool OpeningBook::open(const char* path) {
+  const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+
+  struct stat info {};
+  void* mapped = MAP_FAILED;
+  if (::fstat(fd, &info) == 0 && info.st_size > 0 && info.st_size % BOOK_RECORD_SIZE == 0)
+    mapped = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED)
+    return false;
+
+  // Probes hit a few scattered pages; readahead would only waste memory.
+  ::madvise(mapped, static_cast<std::size_t>(info.st_size), MADV_RANDOM);
+  if (records_)
+    ::munmap(const_cast<unsigned char*>(records_), count_ * BOOK_RECORD_SIZE);
+  records_ = static_cast<const unsigned char*>(mapped);
+  count_ = static_cast<std::size_t>(info.st_size) / BOOK_RECORD_SIZE;
+  return true;
+}
+
+Key OpeningBook::keyAt(std::size_t index) const {
+  return readBigEndian(records_ + index * BOOK_RECORD_SIZE, 8);
+}
+
+std::size_t OpeningBook::probe(const Position& position, std::span<BookMove> moves) const {
+  if (!records_ || moves.empty())
+    return 0;
+
+  const Key key = position.key();
+  std::size_t low = 0;
+  std::size_t high = count_;
+  while (low < high) {
+    const std::size_t middle = low + (high - low) / 2;
+    if (keyAt(middle) < key)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+
+  // Only legal moves count, which also filters out another position that
+  // happens to share the key.
+  MoveList legal;
+  generateLegalMoves(position, legal);
+  std::size_t found = 0;
+  for (std::size_t i = low; i < count_ && keyAt(i) == key && found < moves.size(); ++i) {
+    const unsigned char* record = records_ + i * BOOK_RECORD_SIZE;
+    const Move move = fromBookMove(position, static_cast<std::uint16_t>(readBigEndian(record + 8, 2)));
+    const auto weight = static_cast<std::uint16_t>(readBigEndian(record + 10, 2));
+    if (weight > 0 && legal.contains(move))
+      moves[found++] = {move, weight};
+  }
+  std::stable_sort(moves.begin(), moves.begin() + found,
+                   [](const BookMove& a, const BookMove& b) { return a.weight > b.weight; });
+  return found;
+}
+
+Move OpeningBook::pick(const Position& position, std::uint64_t random) const {
+  std::array<BookMove, MAX_BOOK_MOVES> moves;
+  const std::size_t count = probe(position, moves);
+  std::uint64_t total = 0;
+  for (std::size_t i = 0; i < count; ++i)
+    total += moves[i].weight;
+  if (total == 0)
+    return Move();
+
+  std::uint64_t target = random % total;
+  for (std::size_t i = 0; i < count; ++i) {
+    if (target < moves[i].weight)
+      return moves[i].move;
+    target -= moves[i].weight;
+  }
+  return moves[0].move;
+}
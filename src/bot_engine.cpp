@@ -0,0 +1,46 @@
+#include "bot_engine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+BotEngine::BotEngine(const BotOptions& options)
+    : options_(options), workers_(std::max<std::size_t>(1, options.computeThreads)), pool_(workers_.size()) {
+  if (options_.shareHash)
+    sharedTable_ = std::make_unique<TranspositionTable>(options_.hashMegabytes);
+  for (Worker& worker : workers_) {
+    if (!options_.shareHash)
+      worker.table = std::make_unique<TranspositionTable>(options_.hashMegabytes);
+    worker.search =
+        std::make_unique<SearchPool>(worker.table ? *worker.table : *sharedTable_, options_.searchThreads);
+    worker.random = reinterpret_cast<std::uintptr_t>(&worker) | 1;
+  }
+}
+
+void BotEngine::play(RoomId room, const Position& position, std::vector<Key> history,
+                     std::function<void(Move)> done) {
+  SearchLimits limits = options_.limits;
+  limits.start = std::chrono::steady_clock::now();
+  pool_.submit([this, room, position, history = std::move(history), limits, done = std::move(done)](std::size_t index) {
+    done(chooseMove(workers_[index], room, position, history, limits));
+  });
+}
+
+Move BotEngine::chooseMove(Worker& worker, RoomId room, const Position& position, std::span<const Key> history,
+                           const SearchLimits& limits) {
+  if (options_.book) {
+    // xorshift64: varies the book line from game to game.
+    worker.random ^= worker.random << 13;
+    worker.random ^= worker.random >> 7;
+    worker.random ^= worker.random << 17;
+    const Move move = options_.book->pick(position, worker.random);
+    if (!move.isNull())
+      return move;
+  }
+
+  // Not clear(): wiping the table would eat into the move's time budget.
+  if (worker.table && room != worker.lastRoom)
+    worker.table->retire();
+  worker.lastRoom = room;
+  return worker.search->search(position, limits, history).best;
+}
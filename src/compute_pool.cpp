@@ -0,0 +1,74 @@
+#include "compute_pool.h"
+
+#include <algorithm>
+
+ComputePool::ComputePool(std::size_t threadCount) {
+  const std::size_t count = std::max<std::size_t>(1, threadCount);
+  for (std::size_t i = 0; i < count; ++i)
+    workers_.push_back(std::make_unique<Worker>());
+  for (std::size_t i = 0; i < count; ++i)
+    threads_.emplace_back([this, i] { run(i); });
+}
+
+ComputePool::~ComputePool() {
+  {
+    std::lock_guard lock(sleepMutex_);
+    quit_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread& thread : threads_)
+    thread.join();
+}
+
+void ComputePool::submit(Task task) {
+  // Counted first, so the count never drops below zero, and under the
+  // sleep lock, so a worker about to sleep cannot miss it.
+  {
+    std::lock_guard lock(sleepMutex_);
+    queued_.fetch_add(1, std::memory_order_relaxed);
+  }
+  Worker& worker = *workers_[nextWorker_.fetch_add(1, std::memory_order_relaxed) % workers_.size()];
+  {
+    std::lock_guard lock(worker.mutex);
+    worker.tasks.push_back(std::move(task));
+  }
+  wake_.notify_one();
+}
+
+bool ComputePool::takeTask(std::size_t index, Task& task) {
+  {
+    Worker& own = *workers_[index];
+    std::lock_guard lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.front());
+      own.tasks.pop_front();
+      return true;
+    }
+  }
+  for (std::size_t offset = 1; offset < workers_.size(); ++offset) {
+    Worker& victim = *workers_[(index + offset) % workers_.size()];
+    std::lock_guard lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.back());
+      victim.tasks.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
+
+void ComputePool::run(std::size_t index) {
+  while (true) {
+    Task task;
+    if (takeTask(index, task)) {
+      queued_.fetch_sub(1, std::memory_order_relaxed);
+      task(index);
+      continue;
+    }
+
+    std::unique_lock lock(sleepMutex_);
+    wake_.wait(lock, [this] { return quit_ || queued_.load(std::memory_order_relaxed) > 0; });
+    if (quit_)
+      return;
+  }
+}
@@ -0,0 +1,37 @@
+#include "connection.h"
+
+ConnectionTable::Index ConnectionTable::open(int socket) {
+  Index index;
+  if (!freeSlots_.empty()) {
+    index = freeSlots_.back();
+    freeSlots_.pop_back();
+  } else {
+    index = static_cast<Index>(slots_.size());
+    slots_.emplace_back();
+  }
+
+  Connection& connection = slots_[index];
+  const std::uint32_t generation = connection.generation;
+  connection = Connection{};
+  connection.socket = socket;
+  connection.generation = generation;
+  return index;
+}
+
+void ConnectionTable::release(Index index) {
+  Connection& connection = slots_[index];
+  connection.socket = -1;
+  connection.generation = (connection.generation + 1) & ((1u << kGenerationBits) - 1);
+  // Drops the references to shared broadcasts right away.
+  connection.sendBuffer = OutboundBuffer{};
+  freeSlots_.push_back(index);
+}
+
+ConnectionId ConnectionTable::id(Index index) const {
+  return (static_cast<ConnectionId>(slots_[index].generation) << 32) | index;
+}
+
+bool ConnectionTable::find(ConnectionId id, Index& index) const {
+  index = static_cast<Index>(id);
+  return index < slots_.size() && slots_[index].socket >= 0 && slots_[index].generation == (id >> 32);
+}
@@ -0,0 +1,192 @@
+#include "evaluate.h"
+
+#include <array>
+#include <utility>
+
+#include "bitboard.h"
+
+namespace {
+
+using Table = std::array<int, 64>;
+
+// Tables are written the way a board is drawn, rank 8 first, from white's
+// point of view. A white piece on `square` reads entry square ^ 56, a black
+// one reads entry square.
+constexpr Table KING_TABLE = {
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+     20,  20,   0,   0,   0,   0,  20,  20,
+     20,  30,  10,   0,   0,  10,  30,  20};
+
+constexpr Table QUEEN_TABLE = {
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+      0,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20};
+
+constexpr Table ROOK_TABLE = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+      5,  10,  10,  10,  10,  10,  10,   5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+      0,   0,   0,   5,   5,   0,   0,   0};
+
+constexpr Table BISHOP_TABLE = {
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,   5,   0,   0,   0,   0,   5, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20};
+
+constexpr Table KNIGHT_TABLE = {
+    -50, -40, -30, -30, -30, -30, -40, -50,
+    -40, -20,   0,   0,   0,   0, -20, -40,
+    -30,   0,  10,  15,  15,  10,   0, -30,
+    -30,   5,  15,  20,  20,  15,   5, -30,
+    -30,   0,  15,  20,  20,  15,   0, -30,
+    -30,   5,  10,  15,  15,  10,   5, -30,
+    -40, -20,   0,   5,   5,   0, -20, -40,
+    -50, -40, -30, -30, -30, -30, -40, -50};
+
+constexpr Table PAWN_TABLE = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     10,  10,  20,  30,  30,  20,  10,  10,
+      5,   5,  10,  25,  25,  10,   5,   5,
+      0,   0,   0,  20,  20,   0,   0,   0,
+      5,  -5, -10,   0,   0, -10,  -5,   5,
+      5,  10,  10, -20, -20,  10,  10,   5,
+      0,   0,   0,   0,   0,   0,   0,   0};
+
+constexpr std::array<const Table*, PIECE_TYPE_COUNT> TABLES = {&KING_TABLE,   &QUEEN_TABLE,  &ROOK_TABLE,
+                                                              &BISHOP_TABLE, &KNIGHT_TABLE, &PAWN_TABLE};
+
+// Value of every colored piece on every square, positive for white.
+constexpr std::array<std::array<int, 64>, 2 * PIECE_TYPE_COUNT> PSQ = [] {
+  std::array<std::array<int, 64>, 2 * PIECE_TYPE_COUNT> psq{};
+  for (int type = 0; type < PIECE_TYPE_COUNT; ++type) {
+    for (Square square = 0; square < 64; ++square) {
+      psq[makePiece(Color::kWhite, static_cast<PieceType>(type))][square] =
+          PIECE_VALUES[type] + (*TABLES[type])[square ^ 56];
+      psq[makePiece(Color::kBlack, static_cast<PieceType>(type))][square] =
+          -(PIECE_VALUES[type] + (*TABLES[type])[square]);
+    }
+  }
+  return psq;
+}();
+
+// Up to two pieces leave a square and two arrive (castling, captures).
+struct Changes {
+  std::array<std::pair<PieceCode, Square>, 2> added;
+  std::array<std::pair<PieceCode, Square>, 2> removed;
+  std::size_t addedCount = 0;
+  std::size_t removedCount = 0;
+
+  void add(PieceCode piece, Square square) { added[addedCount++] = {piece, square}; }
+  void remove(PieceCode piece, Square square) { removed[removedCount++] = {piece, square}; }
+};
+
+// Sums every piece on the board into the table score and, with a network,
+// into both perspectives' accumulators.
+void refresh(const Position& position, const Network* net, int& psq, std::array<AccumulatorColumn, 2>& hidden) {
+  psq = 0;
+  Bitboard occupied = position.occupied();
+  while (occupied) {
+    const Square square = popLsb(occupied);
+    psq += PSQ[position.pieceOn(square)][square];
+  }
+  if (!net)
+    return;
+
+  for (const Color perspective : {Color::kWhite, Color::kBlack}) {
+    AccumulatorColumn& column = hidden[static_cast<int>(perspective)];
+    column = net->featureBias;
+    Bitboard pieces = position.occupied();
+    while (pieces) {
+      const Square square = popLsb(pieces);
+      const AccumulatorColumn* add = &net->featureWeights[nnueFeature(perspective, position.pieceOn(square), square)];
+      updateAccumulator(column, column, &add, 1, nullptr, 0);
+    }
+  }
+}
+
+}  // namespace
+
+int evaluate(const Position& position) {
+  const Network* net = network();
+  int psq;
+  std::array<AccumulatorColumn, 2> hidden;
+  refresh(position, net, psq, hidden);
+  const Color us = position.sideToMove();
+  if (net)
+    return networkOutput(*net, hidden[static_cast<int>(us)], hidden[static_cast<int>(opposite(us))]);
+  return us == Color::kWhite ? psq : -psq;
+}
+
+void Evaluator::reset(const Position& position) {
+  net_ = network();
+  top_ = 0;
+  refresh(position, net_, stack_[0].psq, stack_[0].hidden);
+}
+
+void Evaluator::push(const Position& position, Move move, const UndoInfo& undo) {
+  const Color us = opposite(position.sideToMove());
+  const Square from = move.from();
+  const Square to = move.to();
+  const PieceCode placed = position.pieceOn(to);
+
+  Changes changes;
+  changes.remove(move.kind() == MoveKind::kPromotion ? makePiece(us, PieceType::Pawn) : placed, from);
+  changes.add(placed, to);
+  if (undo.captured != NO_PIECE)
+    changes.remove(undo.captured, captureSquare(move, us));
+  if (move.kind() == MoveKind::kCastling) {
+    const PieceCode rook = makePiece(us, PieceType::Rook);
+    changes.remove(rook, castlingRookFrom(to));
+    changes.add(rook, castlingRookTo(to));
+  }
+
+  const Accumulator& parent = stack_[top_];
+  Accumulator& child = stack_[++top_];
+  child.psq = parent.psq;
+  for (std::size_t i = 0; i < changes.addedCount; ++i)
+    child.psq += PSQ[changes.added[i].first][changes.added[i].second];
+  for (std::size_t i = 0; i < changes.removedCount; ++i)
+    child.psq -= PSQ[changes.removed[i].first][changes.removed[i].second];
+  if (!net_)
+    return;
+
+  for (const Color perspective : {Color::kWhite, Color::kBlack}) {
+    std::array<const AccumulatorColumn*, 2> add;
+    std::array<const AccumulatorColumn*, 2> sub;
+    for (std::size_t i = 0; i < changes.addedCount; ++i)
+      add[i] = &net_->featureWeights[nnueFeature(perspective, changes.added[i].first, changes.added[i].second)];
+    for (std::size_t i = 0; i < changes.removedCount; ++i)
+      sub[i] = &net_->featureWeights[nnueFeature(perspective, changes.removed[i].first, changes.removed[i].second)];
+    const int side = static_cast<int>(perspective);
+    updateAccumulator(child.hidden[side], parent.hidden[side], add.data(), changes.addedCount, sub.data(),
+                      changes.removedCount);
+  }
+}
+
+int Evaluator::evaluate(const Position& position) const {
+  const Accumulator& current = stack_[top_];
+  const Color us = position.sideToMove();
+  if (net_)
+    return networkOutput(*net_, current.hidden[static_cast<int>(us)], current.hidden[static_cast<int>(opposite(us))]);
+  return us == Color::kWhite ? current.psq : -current.psq;
+}
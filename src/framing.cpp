@@ -0,0 +1,46 @@
+#include "framing.h"
+
+#include <algorithm>
+
+bool appendFrame(std::string& out, std::string_view payload) {
+  if (payload.empty() || payload.size() > MAX_FRAME_PAYLOAD)
+    return false;
+  out.push_back(static_cast<char>(payload.size() & 0xFF));
+  out.push_back(static_cast<char>(payload.size() >> 8));
+  out.append(payload);
+  return true;
+}
+
+std::span<char> FrameBuffer::writable() {
+  const std::size_t free = kCapacity - size();
+  const std::size_t start = tail_ & (kCapacity - 1);
+  return {data_.data() + start, std::min(free, kCapacity - start)};
+}
+
+void FrameBuffer::commit(std::size_t count) {
+  tail_ += count;
+}
+
+FrameStatus FrameBuffer::nextFrame(std::string_view& payload) {
+  if (size() < FRAME_HEADER_SIZE)
+    return FrameStatus::kIncomplete;
+
+  const std::size_t length = byteAt(0) | (static_cast<std::size_t>(byteAt(1)) << 8);
+  if (length == 0 || length > MAX_FRAME_PAYLOAD)
+    return FrameStatus::kInvalid;
+  if (size() < FRAME_HEADER_SIZE + length)
+    return FrameStatus::kIncomplete;
+
+  const std::size_t start = (head_ + FRAME_HEADER_SIZE) & (kCapacity - 1);
+  if (start + length <= kCapacity) {
+    payload = std::string_view(data_.data() + start, length);
+  } else {
+    // The frame wraps around the end of the ring: stitch it together.
+    const std::size_t firstPart = kCapacity - start;
+    std::copy_n(data_.data() + start, firstPart, scratch_.data());
+    std::copy_n(data_.data(), length - firstPart, scratch_.data() + firstPart);
+    payload = std::string_view(scratch_.data(), length);
+  }
+  head_ += FRAME_HEADER_SIZE + length;
+  return FrameStatus::kReady;
+}
@@ -0,0 +1,145 @@
+#include "game.h"
+
+#include "attacks.h"
+#include "movegen.h"
+#include "protocol.h"
+
+namespace {
+
+bool isPromotionType(PieceType type) {
+  return type == PieceType::Queen || type == PieceType::Rook || type == PieceType::Bishop ||
+         type == PieceType::Knight;
+}
+
+bool canCastle(const Position& position, Color us, Square kingTo) {
+  const bool kingSide = fileOf(kingTo) == 6;
+  const std::uint8_t right = us == Color::kWhite ? (kingSide ? WHITE_OO : WHITE_OOO)
+                                                 : (kingSide ? BLACK_OO : BLACK_OOO);
+  if (!(position.castlingRights() & right))
+    return false;
+
+  const Square kingFrom = position.kingSquare(us);
+  const Square rookFrom = castlingRookFrom(kingTo);
+  const Square low = kingFrom < rookFrom ? kingFrom : rookFrom;
+  const Square high = kingFrom < rookFrom ? rookFrom : kingFrom;
+  for (Square square = low + 1; square < high; ++square) {
+    if (position.pieceOn(square) != NO_PIECE)
+      return false;
+  }
+
+  // The king may not castle out of, through or into check.
+  const Bitboard danger = position.attackedBy(opposite(us));
+  const Square step = kingTo > kingFrom ? 1 : -1;
+  for (Square square = kingFrom; square != kingTo + step; square += step) {
+    if (danger & squareBit(square))
+      return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool isSquareAttacked(const Position& position, Square square, Color by) {
+  return attackersTo(position, square, position.occupied()) & position.pieces(by);
+}
+
+bool isKingInCheck(const Position& position, Color kingColor) {
+  const Square king = position.kingSquare(kingColor);
+  return king != NO_SQUARE && isSquareAttacked(position, king, opposite(kingColor));
+}
+
+bool isMoveValid(const Position& position, Move move) {
+  const Square from = move.from();
+  const Square to = move.to();
+  const PieceCode piece = position.pieceOn(from);
+  if (piece == NO_PIECE || from == to)
+    return false;
+
+  const Color us = pieceColor(piece);
+  if (position.colorOn(to) == us)
+    return false;
+
+  const Bitboard target = squareBit(to);
+  const Bitboard occupied = position.occupied();
+  const PieceType type = pieceType(piece);
+
+  if (type != PieceType::Pawn && type != PieceType::King && move.kind() != MoveKind::kNormal)
+    return false;
+
+  switch (type) {
+    case PieceType::King:
+      if (move.kind() == MoveKind::kCastling)
+        return (to == from + 2 || to == from - 2) && canCastle(position, us, to);
+      return move.kind() == MoveKind::kNormal && (kingAttacks(from) & target);
+
+    case PieceType::Queen:
+      return queenAttacks(from, occupied) & target;
+
+    case PieceType::Rook:
+      return rookAttacks(from, occupied) & target;
+
+    case PieceType::Bishop:
+      return bishopAttacks(from, occupied) & target;
+
+    case PieceType::Knight:
+      return knightAttacks(from) & target;
+
+    case PieceType::Pawn: {
+      if (move.kind() == MoveKind::kEnPassant)
+        return to == position.enPassantSquare() && (pawnAttacks(us, from) & target);
+      const bool lastRank = target & (RANK_1 | RANK_8);
+      if (move.kind() == MoveKind::kCastling || lastRank != (move.kind() == MoveKind::kPromotion))
+        return false;
+      if (move.kind() == MoveKind::kPromotion && !isPromotionType(move.promotion()))
+        return false;
+
+      const Bitboard single = pawnPush(us, squareBit(from)) & ~occupied;
+      const Bitboard doubleRank = us == Color::kWhite ? RANK_4 : RANK_5;
+      const Bitboard pushes = single | (pawnPush(us, single) & ~occupied & doubleRank);
+      if (pushes & target)
+        return true;
+      return (pawnAttacks(us, from) & target) && position.colorOn(to) == opposite(us);
+    }
+  }
+  return false;
+}
+
+bool isMoveLegal(Position& position, Move move) {
+  if (!isMoveValid(position, move))
+    return false;
+
+  const Color us = position.colorOn(move.from());
+  UndoInfo undo;
+  position.makeMove(move, undo);
+  const bool legal = !isKingInCheck(position, us);
+  position.unmakeMove(move, undo);
+  return legal;
+}
+
+bool isCheckmate(const Position& position, Color playerColor) {
+  return position.sideToMove() == playerColor && isKingInCheck(position, playerColor) &&
+         !hasLegalMove(position);
+}
+
+bool isStalemate(const Position& position, Color playerColor) {
+  return position.sideToMove() == playerColor && !isKingInCheck(position, playerColor) &&
+         !hasLegalMove(position);
+}
+
+Move moveFromWire(const Position& position, std::uint8_t from, std::uint8_t to, std::uint8_t promotion) {
+  const PieceCode piece = position.pieceOn(from);
+  const PieceType type = pieceType(piece);
+
+  if (piece != NO_PIECE && type == PieceType::King && (to == from + 2 || to + 2 == from))
+    return Move(from, to, MoveKind::kCastling);
+
+  if (piece != NO_PIECE && type == PieceType::Pawn) {
+    if (squareBit(to) & (RANK_1 | RANK_8)) {
+      const PieceType promoteTo = promotion == NO_PROMOTION ? PieceType::Queen : static_cast<PieceType>(promotion);
+      return Move(from, to, MoveKind::kPromotion, isPromotionType(promoteTo) ? promoteTo : PieceType::Queen);
+    }
+    if (to == position.enPassantSquare() && fileOf(from) != fileOf(to))
+      return Move(from, to, MoveKind::kEnPassant);
+  }
+  return Move(from, to);
+}
@@ -0,0 +1,210 @@
+#include "io_ring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+int ioUringSetup(unsigned entries, io_uring_params& params) {
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+}
+
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+  return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int ioUringRegister(int fd, unsigned opcode, void* arg, unsigned count) {
+  return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+template <typename T>
+T* at(void* base, unsigned offset) {
+  return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+
+}  // namespace
+
+IoRing::IoRing(unsigned entries, unsigned bufferCount, unsigned bufferSize)
+    : bufferCount_(bufferCount), bufferSize_(bufferSize) {
+  io_uring_params params{};
+  // Completions are only looked at when the loop asks for them, so the
+  // kernel need not interrupt the thread to post them.
+  params.flags = IORING_SETUP_COOP_TASKRUN;
+  ringFd_ = ioUringSetup(entries, params);
+  if (ringFd_ < 0) {
+    params = {};
+    ringFd_ = ioUringSetup(entries, params);
+  }
+  if (ringFd_ < 0)
+    return;
+  if (!(params.features & IORING_FEAT_SINGLE_MMAP)) {
+    ::close(ringFd_);
+    ringFd_ = -1;
+    return;
+  }
+
+  ringBytes_ = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+  ringMemory_ = ::mmap(nullptr, ringBytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_,
+                       IORING_OFF_SQ_RING);
+  sqeBytes_ = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqes = ::mmap(nullptr, sqeBytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_,
+                      IORING_OFF_SQES);
+  if (ringMemory_ == MAP_FAILED || sqes == MAP_FAILED) {
+    if (ringMemory_ != MAP_FAILED)
+      ::munmap(ringMemory_, ringBytes_);
+    if (sqes != MAP_FAILED)
+      ::munmap(sqes, sqeBytes_);
+    ringMemory_ = nullptr;
+    ::close(ringFd_);
+    ringFd_ = -1;
+    return;
+  }
+  sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+  sqHead_ = at<unsigned>(ringMemory_, params.sq_off.head);
+  sqTail_ = at<unsigned>(ringMemory_, params.sq_off.tail);
+  sqArray_ = at<unsigned>(ringMemory_, params.sq_off.array);
+  sqMask_ = *at<unsigned>(ringMemory_, params.sq_off.ring_mask);
+  sqEntries_ = params.sq_entries;
+  sqLocalTail_ = *sqTail_;
+  // Slot i of the queue always holds entry i.
+  for (unsigned i = 0; i < sqEntries_; ++i)
+    sqArray_[i] = i;
+
+  cqHead_ = at<unsigned>(ringMemory_, params.cq_off.head);
+  cqTail_ = at<unsigned>(ringMemory_, params.cq_off.tail);
+  cqes_ = at<io_uring_cqe>(ringMemory_, params.cq_off.cqes);
+  cqMask_ = *at<unsigned>(ringMemory_, params.cq_off.ring_mask);
+
+  if (setupBufferRing())
+    multishotReceive_ = probeMultishotReceive();
+}
+
+IoRing::~IoRing() {
+  if (ringFd_ >= 0)
+    ::close(ringFd_);
+  if (bufferRing_)
+    ::munmap(bufferRing_, bufferRingBytes_);
+  if (buffers_)
+    ::munmap(buffers_, static_cast<std::size_t>(bufferCount_) * bufferSize_);
+  if (sqes_)
+    ::munmap(sqes_, sqeBytes_);
+  if (ringMemory_)
+    ::munmap(ringMemory_, ringBytes_);
+}
+
+bool IoRing::setupBufferRing() {
+  bufferRingBytes_ = bufferCount_ * sizeof(io_uring_buf);
+  void* ring = ::mmap(nullptr, bufferRingBytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  void* buffers = ::mmap(nullptr, static_cast<std::size_t>(bufferCount_) * bufferSize_, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (ring == MAP_FAILED || buffers == MAP_FAILED) {
+    if (ring != MAP_FAILED)
+      ::munmap(ring, bufferRingBytes_);
+    if (buffers != MAP_FAILED)
+      ::munmap(buffers, static_cast<std::size_t>(bufferCount_) * bufferSize_);
+    return false;
+  }
+
+  io_uring_buf_reg registration{};
+  registration.ring_addr = reinterpret_cast<std::uint64_t>(ring);
+  registration.ring_entries = bufferCount_;
+  registration.bgid = kBufferGroup;
+  if (ioUringRegister(ringFd_, IORING_REGISTER_PBUF_RING, &registration, 1) < 0) {
+    ::munmap(ring, bufferRingBytes_);
+    ::munmap(buffers, static_cast<std::size_t>(bufferCount_) * bufferSize_);
+    return false;
+  }
+
+  bufferRing_ = static_cast<io_uring_buf_ring*>(ring);
+  buffers_ = static_cast<char*>(buffers);
+  for (unsigned i = 0; i < bufferCount_; ++i)
+    recycle(static_cast<std::uint16_t>(i));
+  return true;
+}
+
+void IoRing::recycle(std::uint16_t id) {
+  // Not bufferRing_->bufs: in C++ the uapi flexible array wrapper has a
+  // one byte empty member and puts the array at offset 8 instead of 0.
+  io_uring_buf& slot = reinterpret_cast<io_uring_buf*>(bufferRing_)[bufferTail_ & (bufferCount_ - 1)];
+  slot.addr = reinterpret_cast<std::uint64_t>(buffers_ + static_cast<std::size_t>(id) * bufferSize_);
+  slot.len = bufferSize_;
+  slot.bid = id;
+  ++bufferTail_;
+  std::atomic_ref(bufferRing_->tail).store(bufferTail_, std::memory_order_release);
+}
+
+bool IoRing::probeMultishotReceive() {
+  int sockets[2];
+  if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) < 0)
+    return false;
+
+  bool supported = false;
+  const char byte = 0;
+  io_uring_sqe* sqe = ::write(sockets[1], &byte, 1) == 1 ? nextEntry() : nullptr;
+  if (sqe) {
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = sockets[0];
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kBufferGroup;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+
+    // The byte comes back with IORING_CQE_F_MORE set where multishot is
+    // supported; shutdown() then ends the request, and the ring is left
+    // with nothing in flight.
+    bool pending = true;
+    while (pending && submitAndWait()) {
+      forEachCompletion([&](const io_uring_cqe& cqe) {
+        if (cqe.flags & IORING_CQE_F_BUFFER)
+          recycle(static_cast<std::uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+        if (cqe.res > 0 && (cqe.flags & IORING_CQE_F_MORE)) {
+          supported = true;
+          ::shutdown(sockets[0], SHUT_RDWR);
+        }
+        if (!(cqe.flags & IORING_CQE_F_MORE))
+          pending = false;
+      });
+    }
+  }
+  ::close(sockets[0]);
+  ::close(sockets[1]);
+  return supported;
+}
+
+io_uring_sqe* IoRing::nextEntry() {
+  if (sqLocalTail_ - std::atomic_ref(*sqHead_).load(std::memory_order_acquire) == sqEntries_) {
+    std::atomic_ref(*sqTail_).store(sqLocalTail_, std::memory_order_release);
+    const int submitted = ioUringEnter(ringFd_, toSubmit_, 0, 0);
+    if (submitted <= 0)
+      return nullptr;
+    toSubmit_ -= static_cast<unsigned>(submitted);
+  }
+  io_uring_sqe* sqe = &sqes_[sqLocalTail_ & sqMask_];
+  std::memset(sqe, 0, sizeof(*sqe));
+  ++sqLocalTail_;
+  ++toSubmit_;
+  return sqe;
+}
+
+bool IoRing::submitAndWait() {
+  // Nothing to submit and completions already waiting: no need to enter.
+  if (toSubmit_ == 0 && *cqHead_ != std::atomic_ref(*cqTail_).load(std::memory_order_acquire))
+    return true;
+  std::atomic_ref(*sqTail_).store(sqLocalTail_, std::memory_order_release);
+  while (true) {
+    const int submitted = ioUringEnter(ringFd_, toSubmit_, 1, IORING_ENTER_GETEVENTS);
+    if (submitted >= 0) {
+      toSubmit_ -= static_cast<unsigned>(submitted);
+      return true;
+    }
+    if (errno != EINTR)
+      return false;
+  }
+}
@@ -0,0 +1,168 @@
+#include "movegen.h"
+
+#include "attacks.h"
+
+namespace {
+
+void pushPawnMove(MoveList& moves, Square from, Square to) {
+  if (rankOf(to) == 0 || rankOf(to) == 7) {
+    moves.push(Move(from, to, MoveKind::kPromotion, PieceType::Queen));
+    moves.push(Move(from, to, MoveKind::kPromotion, PieceType::Rook));
+    moves.push(Move(from, to, MoveKind::kPromotion, PieceType::Bishop));
+    moves.push(Move(from, to, MoveKind::kPromotion, PieceType::Knight));
+  } else {
+    moves.push(Move(from, to));
+  }
+}
+
+void pushMoves(MoveList& moves, Square from, Bitboard targets) {
+  while (targets) {
+    moves.push(Move(from, popLsb(targets)));
+  }
+}
+
+// With StopAtFirst the generator returns as soon as one piece group has
+// produced a move; king moves come first since they are the usual answer
+// to a check. With CapturesOnly it keeps captures and promotions, plus
+// every evasion when in check.
+template <bool StopAtFirst, bool CapturesOnly = false>
+bool generate(const Position& position, MoveList& moves) {
+  const Color us = position.sideToMove();
+  const Color them = opposite(us);
+  const Bitboard own = position.pieces(us);
+  const Bitboard enemy = position.pieces(them);
+  const Bitboard occupied = position.occupied();
+  const Square king = position.kingSquare(us);
+
+  const Bitboard theirQueens = position.pieces(them, PieceType::Queen);
+  const Bitboard theirDiagonal = position.pieces(them, PieceType::Bishop) | theirQueens;
+  const Bitboard theirStraight = position.pieces(them, PieceType::Rook) | theirQueens;
+  const Bitboard checkers = attackersTo(position, king, occupied) & enemy;
+
+  // Without the king on its square, so that a slider checking it also
+  // covers the squares behind it.
+  const Bitboard danger = position.attackedBy(them, occupied ^ squareBit(king));
+
+  // Where non-pawn moves may land; pawns also keep their promotions.
+  const Bitboard quietMask = CapturesOnly && !checkers ? enemy : ~Bitboard{0};
+
+  pushMoves(moves, king, kingAttacks(king) & ~own & ~danger & quietMask);
+  if (StopAtFirst && !moves.empty())
+    return true;
+  if (checkers & (checkers - 1))
+    return !moves.empty();
+
+  // In check, every other move has to capture the checker or block it.
+  const Bitboard checkMask = checkers ? between(king, lsb(checkers)) | checkers : ~Bitboard{0};
+
+  Bitboard pinned = 0;
+  Bitboard snipers = (rookAttacks(king, enemy) & theirStraight) | (bishopAttacks(king, enemy) & theirDiagonal);
+  while (snipers) {
+    const Bitboard blockers = between(king, popLsb(snipers)) & occupied;
+    if (blockers && !(blockers & (blockers - 1)) && (blockers & own))
+      pinned |= blockers;
+  }
+
+  auto targetsFor = [&](Square from, Bitboard targets) {
+    targets &= ~own & checkMask;
+    if (pinned & squareBit(from))
+      targets &= line(king, from);
+    return targets;
+  };
+
+  // A pinned knight can never move.
+  Bitboard knights = position.pieces(us, PieceType::Knight) & ~pinned;
+  while (knights) {
+    const Square from = popLsb(knights);
+    pushMoves(moves, from, targetsFor(from, knightAttacks(from) & quietMask));
+  }
+  Bitboard diagonal = position.pieces(us, PieceType::Bishop) | position.pieces(us, PieceType::Queen);
+  while (diagonal) {
+    const Square from = popLsb(diagonal);
+    pushMoves(moves, from, targetsFor(from, bishopAttacks(from, occupied) & quietMask));
+  }
+  Bitboard straight = position.pieces(us, PieceType::Rook) | position.pieces(us, PieceType::Queen);
+  while (straight) {
+    const Square from = popLsb(straight);
+    pushMoves(moves, from, targetsFor(from, rookAttacks(from, occupied) & quietMask));
+  }
+  if (StopAtFirst && !moves.empty())
+    return true;
+
+  const Square enPassant = position.enPassantSquare();
+  const Bitboard doubleRank = us == Color::kWhite ? RANK_4 : RANK_5;
+  Bitboard pawns = position.pieces(us, PieceType::Pawn);
+  while (pawns) {
+    const Square from = popLsb(pawns);
+    const Bitboard bit = squareBit(from);
+    const Bitboard single = pawnPush(us, bit) & ~occupied;
+    Bitboard targets = single | (pawnPush(us, single) & ~occupied & doubleRank) |
+                       (pawnAttacks(us, from) & enemy);
+    targets = targetsFor(from, targets & (quietMask | RANK_1 | RANK_8));
+    while (targets) {
+      pushPawnMove(moves, from, popLsb(targets));
+    }
+
+    // En passant removes two pieces from the same rank, which ordinary pin
+    // detection misses; replay the occupancy change and look at the king.
+    if (enPassant != NO_SQUARE && (pawnAttacks(us, from) & squareBit(enPassant))) {
+      const Move move(from, enPassant, MoveKind::kEnPassant);
+      const Bitboard captured = squareBit(captureSquare(move, us));
+      const Bitboard after = (occupied ^ bit ^ captured) | squareBit(enPassant);
+      if (!(attackersTo(position, king, after) & enemy & ~captured))
+        moves.push(move);
+    }
+  }
+
+  if (!checkers && !CapturesOnly) {
+    const bool white = us == Color::kWhite;
+    const std::uint8_t rights = position.castlingRights() & (white ? WHITE_OO | WHITE_OOO : BLACK_OO | BLACK_OOO);
+    for (const Square kingTo : {king + 2, king - 2}) {
+      const std::uint8_t right = kingTo > king ? (white ? WHITE_OO : BLACK_OO) : (white ? WHITE_OOO : BLACK_OOO);
+      if (!(rights & right))
+        continue;
+      const Bitboard path = between(king, castlingRookFrom(kingTo)) & occupied;
+      const Bitboard crossed = between(king, kingTo) | squareBit(kingTo);
+      if (!path && !(crossed & danger))
+        moves.push(Move(king, kingTo, MoveKind::kCastling));
+    }
+  }
+
+  return !moves.empty();
+}
+
+}  // namespace
+
+Bitboard attackersTo(const Position& position, Square square, Bitboard occupied) {
+  const Bitboard queens = position.pieces(Color::kWhite, PieceType::Queen) |
+                          position.pieces(Color::kBlack, PieceType::Queen);
+  const Bitboard rooks = position.pieces(Color::kWhite, PieceType::Rook) |
+                         position.pieces(Color::kBlack, PieceType::Rook);
+  const Bitboard bishops = position.pieces(Color::kWhite, PieceType::Bishop) |
+                           position.pieces(Color::kBlack, PieceType::Bishop);
+  const Bitboard knights = position.pieces(Color::kWhite, PieceType::Knight) |
+                           position.pieces(Color::kBlack, PieceType::Knight);
+  const Bitboard kings = position.pieces(Color::kWhite, PieceType::King) |
+                         position.pieces(Color::kBlack, PieceType::King);
+
+  return (pawnAttacks(Color::kWhite, square) & position.pieces(Color::kBlack, PieceType::Pawn)) |
+         (pawnAttacks(Color::kBlack, square) & position.pieces(Color::kWhite, PieceType::Pawn)) |
+         (knightAttacks(square) & knights) | (kingAttacks(square) & kings) |
+         (rookAttacks(square, occupied) & (rooks | queens)) |
+         (bishopAttacks(square, occupied) & (bishops | queens));
+}
+
+void generateLegalMoves(const Position& position, MoveList& moves) {
+  moves.clear();
+  generate<false>(position, moves);
+}
+
+void generateLegalCaptures(const Position& position, MoveList& moves) {
+  moves.clear();
+  generate<false, true>(position, moves);
+}
+
+bool hasLegalMove(const Position& position) {
+  MoveList moves;
+  return generate<true>(position, moves);
+}
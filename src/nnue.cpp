@@ -0,0 +1,223 @@
+#include "nnue.h"
+
+#include <algorithm>
+#include <bit>
+#include <fstream>
+#include <memory>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NNUE_X86 1
+#endif
+
+namespace {
+
+// Accumulator values are clipped to [0, QA] before the output layer, whose
+// weights are scaled by QB; OUTPUT_SCALE turns the result into centipawns.
+constexpr int QA = 255;
+constexpr int QB = 64;
+constexpr int OUTPUT_SCALE = 400;
+
+constexpr std::uint32_t NETWORK_MAGIC = 0x45554E4E;  // "NNUE"
+constexpr std::uint32_t NETWORK_VERSION = 1;
+
+std::unique_ptr<Network> NETWORK;
+
+// ---- scalar -------------------------------------------------------------
+
+std::int32_t dotScalar(const AccumulatorColumn& us, const AccumulatorColumn& them, const std::int16_t* weights) {
+  std::int32_t sum = 0;
+  for (std::size_t i = 0; i < NNUE_HIDDEN; ++i)
+    sum += std::clamp<int>(us[i], 0, QA) * weights[i];
+  for (std::size_t i = 0; i < NNUE_HIDDEN; ++i)
+    sum += std::clamp<int>(them[i], 0, QA) * weights[NNUE_HIDDEN + i];
+  return sum;
+}
+
+void updateScalar(AccumulatorColumn& dst, const AccumulatorColumn& src, const AccumulatorColumn* const* add,
+                  std::size_t addCount, const AccumulatorColumn* const* sub, std::size_t subCount) {
+  for (std::size_t i = 0; i < NNUE_HIDDEN; ++i) {
+    int value = src[i];
+    for (std::size_t k = 0; k < addCount; ++k)
+      value += (*add[k])[i];
+    for (std::size_t k = 0; k < subCount; ++k)
+      value -= (*sub[k])[i];
+    dst[i] = static_cast<std::int16_t>(value);
+  }
+}
+
+#ifdef NNUE_X86
+
+// ---- SSE4.1: 8 lanes ----------------------------------------------------
+
+__attribute__((target("sse4.1"))) std::int32_t dotSse41(const AccumulatorColumn& us, const AccumulatorColumn& them,
+                                                        const std::int16_t* weights) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i ceiling = _mm_set1_epi16(QA);
+  __m128i sum = _mm_setzero_si128();
+  for (const AccumulatorColumn* side : {&us, &them}) {
+    for (std::size_t i = 0; i < NNUE_HIDDEN; i += 8) {
+      __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(side->data() + i));
+      value = _mm_min_epi16(_mm_max_epi16(value, zero), ceiling);
+      const __m128i weight = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+      sum = _mm_add_epi32(sum, _mm_madd_epi16(value, weight));
+    }
+    weights += NNUE_HIDDEN;
+  }
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(sum);
+}
+
+__attribute__((target("sse4.1"))) void updateSse41(AccumulatorColumn& dst, const AccumulatorColumn& src,
+                                                   const AccumulatorColumn* const* add, std::size_t addCount,
+                                                   const AccumulatorColumn* const* sub, std::size_t subCount) {
+  for (std::size_t i = 0; i < NNUE_HIDDEN; i += 8) {
+    __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src.data() + i));
+    for (std::size_t k = 0; k < addCount; ++k)
+      value = _mm_add_epi16(value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(add[k]->data() + i)));
+    for (std::size_t k = 0; k < subCount; ++k)
+      value = _mm_sub_epi16(value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(sub[k]->data() + i)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst.data() + i), value);
+  }
+}
+
+// ---- AVX2: 16 lanes -----------------------------------------------------
+
+__attribute__((target("avx2"))) std::int32_t dotAvx2(const AccumulatorColumn& us, const AccumulatorColumn& them,
+                                                     const std::int16_t* weights) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i ceiling = _mm256_set1_epi16(QA);
+  __m256i sum = _mm256_setzero_si256();
+  for (const AccumulatorColumn* side : {&us, &them}) {
+    for (std::size_t i = 0; i < NNUE_HIDDEN; i += 16) {
+      __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(side->data() + i));
+      value = _mm256_min_epi16(_mm256_max_epi16(value, zero), ceiling);
+      const __m256i weight = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+      sum = _mm256_add_epi32(sum, _mm256_madd_epi16(value, weight));
+    }
+    weights += NNUE_HIDDEN;
+  }
+  __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+  half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+  half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(half);
+}
+
+__attribute__((target("avx2"))) void updateAvx2(AccumulatorColumn& dst, const AccumulatorColumn& src,
+                                                const AccumulatorColumn* const* add, std::size_t addCount,
+                                                const AccumulatorColumn* const* sub, std::size_t subCount) {
+  for (std::size_t i = 0; i < NNUE_HIDDEN; i += 16) {
+    __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src.data() + i));
+    for (std::size_t k = 0; k < addCount; ++k)
+      value = _mm256_add_epi16(value, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(add[k]->data() + i)));
+    for (std::size_t k = 0; k < subCount; ++k)
+      value = _mm256_sub_epi16(value, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sub[k]->data() + i)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst.data() + i), value);
+  }
+}
+
+#endif  // NNUE_X86
+
+static_assert(NNUE_HIDDEN % 16 == 0, "the SIMD kernels work on whole 256 bit registers");
+
+using DotKernel = std::int32_t (*)(const AccumulatorColumn&, const AccumulatorColumn&, const std::int16_t*);
+using UpdateKernel = void (*)(AccumulatorColumn&, const AccumulatorColumn&, const AccumulatorColumn* const*,
+                              std::size_t, const AccumulatorColumn* const*, std::size_t);
+
+struct Kernels {
+  SimdLevel level;
+  DotKernel dot;
+  UpdateKernel update;
+};
+
+Kernels kernelsFor(SimdLevel level) {
+#ifdef NNUE_X86
+  switch (level) {
+    case SimdLevel::kAvx2:
+      return {level, dotAvx2, updateAvx2};
+    case SimdLevel::kSse41:
+      return {level, dotSse41, updateSse41};
+    case SimdLevel::kScalar:
+      break;
+  }
+#endif
+  return {SimdLevel::kScalar, dotScalar, updateScalar};
+}
+
+Kernels KERNELS = kernelsFor(detectSimd());
+
+template <typename T>
+bool readLittleEndian(std::istream& in, T* values, std::size_t count) {
+  static_assert(std::endian::native == std::endian::little, "network files are little-endian");
+  in.read(reinterpret_cast<char*>(values), static_cast<std::streamsize>(sizeof(T) * count));
+  return static_cast<bool>(in);
+}
+
+}  // namespace
+
+bool loadNetwork(const char* path) {
+  std::ifstream in(path, std::ios::binary);
+  std::uint32_t header[3];
+  if (!in || !readLittleEndian(in, header, 3) || header[0] != NETWORK_MAGIC || header[1] != NETWORK_VERSION ||
+      header[2] != NNUE_HIDDEN)
+    return false;
+
+  auto net = std::make_unique<Network>();
+  net->featureWeights.resize(NNUE_INPUTS);
+  for (AccumulatorColumn& column : net->featureWeights) {
+    if (!readLittleEndian(in, column.data(), NNUE_HIDDEN))
+      return false;
+  }
+  if (!readLittleEndian(in, net->featureBias.data(), NNUE_HIDDEN) ||
+      !readLittleEndian(in, net->outputWeights.data(), net->outputWeights.size()) ||
+      !readLittleEndian(in, &net->outputBias, 1))
+    return false;
+
+  NETWORK = std::move(net);
+  return true;
+}
+
+const Network* network() {
+  return NETWORK.get();
+}
+
+int networkOutput(const Network& net, const AccumulatorColumn& us, const AccumulatorColumn& them) {
+  const std::int64_t sum = KERNELS.dot(us, them, net.outputWeights.data()) + static_cast<std::int64_t>(net.outputBias);
+  return static_cast<int>(sum * OUTPUT_SCALE / (QA * QB));
+}
+
+void updateAccumulator(AccumulatorColumn& dst, const AccumulatorColumn& src, const AccumulatorColumn* const* add,
+                       std::size_t addCount, const AccumulatorColumn* const* sub, std::size_t subCount) {
+  KERNELS.update(dst, src, add, addCount, sub, subCount);
+}
+
+SimdLevel detectSimd() {
+#ifdef NNUE_X86
+  if (__builtin_cpu_supports("avx2"))
+    return SimdLevel::kAvx2;
+  if (__builtin_cpu_supports("sse4.1"))
+    return SimdLevel::kSse41;
+#endif
+  return SimdLevel::kScalar;
+}
+
+void useSimd(SimdLevel level) {
+  KERNELS = kernelsFor(std::min(level, detectSimd()));
+}
+
+SimdLevel activeSimd() {
+  return KERNELS.level;
+}
+
+const char* simdName(SimdLevel level) {
+  switch (level) {
+    case SimdLevel::kAvx2:
+      return "avx2";
+    case SimdLevel::kSse41:
+      return "sse4.1";
+    case SimdLevel::kScalar:
+      break;
+  }
+  return "scalar";
+}
@@ -0,0 +1,52 @@
+#include "outbound.h"
+
+#include <cerrno>
+
+void OutboundBuffer::append(SharedBytes data) {
+  if (data->empty())
+    return;
+  size_ += data->size();
+  messages_.push_back(std::move(data));
+}
+
+FlushStatus OutboundBuffer::flush(int fd) {
+  while (!empty()) {
+    const ssize_t sent = ::sendmsg(fd, prepare(), MSG_NOSIGNAL);
+    if (sent < 0 && errno == EINTR)
+      continue;
+    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return FlushStatus::kPending;
+    if (sent <= 0)
+      return FlushStatus::kError;
+    consume(static_cast<std::size_t>(sent));
+  }
+  return FlushStatus::kDone;
+}
+
+const msghdr* OutboundBuffer::prepare() {
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < messages_.size() && count < chunks_.size(); ++i, ++count) {
+    const std::string& message = *messages_[i];
+    const std::size_t skip = i == 0 ? offset_ : 0;
+    chunks_[count] = {const_cast<char*>(message.data()) + skip, message.size() - skip};
+  }
+  header_ = {};
+  header_.msg_iov = chunks_.data();
+  header_.msg_iovlen = count;
+  return &header_;
+}
+
+void OutboundBuffer::consume(std::size_t written) {
+  // Release every message written in full; a partial one stays first.
+  size_ -= written;
+  while (written > 0) {
+    const std::size_t left = messages_.front()->size() - offset_;
+    if (written < left) {
+      offset_ += written;
+      break;
+    }
+    written -= left;
+    offset_ = 0;
+    messages_.pop_front();
+  }
+}
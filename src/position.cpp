@@ -0,0 +1,280 @@
+#include "position.h"
+
+#include <algorithm>
+#include <charconv>
+
+#include "attacks.h"
+
+namespace {
+
+// Castling rights kept when a piece moves from or to a square: touching a
+// king or rook home square drops the matching rights.
+constexpr std::array<std::uint8_t, 64> makeCastlingMask() {
+  std::array<std::uint8_t, 64> mask{};
+  for (auto& rights : mask)
+    rights = WHITE_OO | WHITE_OOO | BLACK_OO | BLACK_OOO;
+  mask[squareFromXY(4, 7)] &= ~(WHITE_OO | WHITE_OOO);
+  mask[squareFromXY(7, 7)] &= ~WHITE_OO;
+  mask[squareFromXY(0, 7)] &= ~WHITE_OOO;
+  mask[squareFromXY(4, 0)] &= ~(BLACK_OO | BLACK_OOO);
+  mask[squareFromXY(7, 0)] &= ~BLACK_OO;
+  mask[squareFromXY(0, 0)] &= ~BLACK_OOO;
+  return mask;
+}
+
+constexpr std::array<std::uint8_t, 64> CASTLING_MASK = makeCastlingMask();
+
+}  // namespace
+
+Position Position::startPosition() {
+  static constexpr std::array<PieceType, 8> backRank = {
+      PieceType::Rook, PieceType::Knight, PieceType::Bishop, PieceType::Queen,
+      PieceType::King, PieceType::Bishop, PieceType::Knight, PieceType::Rook};
+
+  Position position;
+  for (int x = 0; x < 8; ++x) {
+    position.put(makePiece(Color::kWhite, backRank[x]), squareFromXY(x, 7));
+    position.put(makePiece(Color::kWhite, PieceType::Pawn), squareFromXY(x, 6));
+    position.put(makePiece(Color::kBlack, backRank[x]), squareFromXY(x, 0));
+    position.put(makePiece(Color::kBlack, PieceType::Pawn), squareFromXY(x, 1));
+  }
+  position.castling_ = WHITE_OO | WHITE_OOO | BLACK_OO | BLACK_OOO;
+  position.key_ = position.computeKey();
+  return position;
+}
+
+bool Position::fromFen(std::string_view fen, Position& position) {
+  auto nextField = [&fen]() {
+    while (!fen.empty() && fen.front() == ' ')
+      fen.remove_prefix(1);
+    const std::size_t end = std::min(fen.find(' '), fen.size());
+    const std::string_view field = fen.substr(0, end);
+    fen.remove_prefix(end);
+    return field;
+  };
+
+  Position parsed;
+  int rank = 7;
+  int file = 0;
+  for (const char c : nextField()) {
+    if (c == '/') {
+      if (file != 8 || rank == 0)
+        return false;
+      --rank;
+      file = 0;
+    } else if (c >= '1' && c <= '8') {
+      file += c - '0';
+    } else {
+      static constexpr std::string_view kLetters = "kqrbnp";
+      const char lower = static_cast<char>(c | 0x20);
+      const std::size_t type = kLetters.find(lower);
+      if (type == std::string_view::npos || file > 7)
+        return false;
+      parsed.put(makePiece(c == lower ? Color::kBlack : Color::kWhite, static_cast<PieceType>(type)),
+                 rank * 8 + file);
+      ++file;
+    }
+    if (file > 8)
+      return false;
+  }
+  if (rank != 0 || file != 8 || popCount(parsed.pieces(Color::kWhite, PieceType::King)) != 1 ||
+      popCount(parsed.pieces(Color::kBlack, PieceType::King)) != 1)
+    return false;
+
+  const std::string_view side = nextField();
+  if (side != "w" && side != "b")
+    return false;
+  parsed.sideToMove_ = side == "w" ? Color::kWhite : Color::kBlack;
+
+  const std::string_view castling = nextField();
+  if (castling != "-") {
+    for (const char c : castling) {
+      switch (c) {
+        case 'K': parsed.castling_ |= WHITE_OO; break;
+        case 'Q': parsed.castling_ |= WHITE_OOO; break;
+        case 'k': parsed.castling_ |= BLACK_OO; break;
+        case 'q': parsed.castling_ |= BLACK_OOO; break;
+        default: return false;
+      }
+    }
+  }
+  // Rights whose king or rook is not at home are dropped, like Polyglot does.
+  for (Square square = 0; square < 64; ++square) {
+    const PieceCode piece = parsed.board_[square];
+    const bool home = piece != NO_PIECE &&
+                      (pieceType(piece) == PieceType::King || pieceType(piece) == PieceType::Rook) &&
+                      rankOf(square) == (pieceColor(piece) == Color::kWhite ? 0 : 7);
+    if (!home)
+      parsed.castling_ &= CASTLING_MASK[square];
+  }
+
+  const std::string_view enPassant = nextField();
+  if (enPassant != "-") {
+    if (enPassant.size() != 2 || enPassant[0] < 'a' || enPassant[0] > 'h' ||
+        (enPassant[1] != '3' && enPassant[1] != '6'))
+      return false;
+    parsed.enPassant_ = (enPassant[1] - '1') * 8 + (enPassant[0] - 'a');
+    if (!(pawnAttacks(opposite(parsed.sideToMove_), parsed.enPassant_) &
+          parsed.pieces(parsed.sideToMove_, PieceType::Pawn)))
+      parsed.enPassant_ = NO_SQUARE;
+  }
+
+  for (int* counter : {&parsed.halfmoveClock_, &parsed.fullmoveNumber_}) {
+    const std::string_view field = nextField();
+    if (field.empty())
+      break;
+    if (std::from_chars(field.data(), field.data() + field.size(), *counter).ec != std::errc())
+      return false;
+  }
+
+  parsed.key_ = parsed.computeKey();
+  position = parsed;
+  return true;
+}
+
+bool Position::fromPieces(std::span<const PieceCode> pieces, std::span<const Square> squares, Color sideToMove,
+                          Position& position) {
+  Position placed;
+  for (std::size_t i = 0; i < pieces.size(); ++i) {
+    if (placed.board_[squares[i]] != NO_PIECE)
+      return false;
+    placed.put(pieces[i], squares[i]);
+  }
+  if (popCount(placed.pieces(Color::kWhite, PieceType::King)) != 1 ||
+      popCount(placed.pieces(Color::kBlack, PieceType::King)) != 1)
+    return false;
+
+  placed.sideToMove_ = sideToMove;
+  placed.key_ = placed.computeKey();
+  position = placed;
+  return true;
+}
+
+void Position::put(PieceCode piece, Square square) {
+  const Bitboard bit = squareBit(square);
+  pieces_[piece] |= bit;
+  occupancy_[static_cast<int>(pieceColor(piece))] |= bit;
+  occupied_ |= bit;
+  board_[square] = piece;
+  key_ ^= pieceKey(piece, square);
+  if (pieceType(piece) == PieceType::King)
+    kingSquares_[static_cast<int>(pieceColor(piece))] = square;
+}
+
+void Position::remove(Square square) {
+  const PieceCode piece = board_[square];
+  const Bitboard bit = squareBit(square);
+  pieces_[piece] &= ~bit;
+  occupancy_[static_cast<int>(pieceColor(piece))] &= ~bit;
+  occupied_ &= ~bit;
+  board_[square] = NO_PIECE;
+  key_ ^= pieceKey(piece, square);
+}
+
+void Position::makeMove(Move move, UndoInfo& undo) {
+  const Color us = sideToMove_;
+  const Square from = move.from();
+  const Square to = move.to();
+  const PieceCode moving = board_[from];
+
+  const Square capturedOn = captureSquare(move, us);
+  const PieceCode captured = board_[capturedOn];
+  undo.captured = captured;
+  undo.castling = castling_;
+  undo.enPassant = static_cast<std::uint8_t>(enPassant_);
+  undo.halfmoveClock = static_cast<std::uint16_t>(halfmoveClock_);
+  undo.key = key_;
+
+  if (captured != NO_PIECE)
+    remove(capturedOn);
+
+  remove(from);
+  put(move.kind() == MoveKind::kPromotion ? makePiece(us, move.promotion()) : moving, to);
+
+  if (move.kind() == MoveKind::kCastling) {
+    const Square rookFrom = castlingRookFrom(to);
+    const PieceCode rook = board_[rookFrom];
+    remove(rookFrom);
+    put(rook, castlingRookTo(to));
+  }
+
+  if (enPassant_ != NO_SQUARE)
+    key_ ^= enPassantKey(enPassant_);
+  enPassant_ = NO_SQUARE;
+  if (pieceType(moving) == PieceType::Pawn && (to - from == 16 || from - to == 16)) {
+    const Square passed = (from + to) / 2;
+    if (pawnAttacks(us, passed) & pieces(opposite(us), PieceType::Pawn)) {
+      enPassant_ = passed;
+      key_ ^= enPassantKey(passed);
+    }
+  }
+
+  key_ ^= castlingKey(castling_);
+  castling_ &= CASTLING_MASK[from] & CASTLING_MASK[to];
+  key_ ^= castlingKey(castling_);
+
+  if (captured != NO_PIECE || pieceType(moving) == PieceType::Pawn)
+    halfmoveClock_ = 0;
+  else
+    ++halfmoveClock_;
+  if (us == Color::kBlack)
+    ++fullmoveNumber_;
+
+  sideToMove_ = opposite(us);
+  key_ ^= sideKey();
+}
+
+void Position::unmakeMove(Move move, const UndoInfo& undo) {
+  const Color us = opposite(sideToMove_);
+  const Square from = move.from();
+  const Square to = move.to();
+
+  if (move.kind() == MoveKind::kCastling) {
+    const Square rookTo = castlingRookTo(to);
+    const PieceCode rook = board_[rookTo];
+    remove(rookTo);
+    put(rook, castlingRookFrom(to));
+  }
+
+  const PieceCode moved = move.kind() == MoveKind::kPromotion ? makePiece(us, PieceType::Pawn) : board_[to];
+  remove(to);
+  put(moved, from);
+  if (undo.captured != NO_PIECE)
+    put(undo.captured, captureSquare(move, us));
+
+  castling_ = undo.castling;
+  enPassant_ = undo.enPassant;
+  halfmoveClock_ = undo.halfmoveClock;
+  if (us == Color::kBlack)
+    --fullmoveNumber_;
+  sideToMove_ = us;
+  key_ = undo.key;
+}
+
+Key Position::computeKey() const {
+  Key key = castlingKey(castling_);
+  for (Square square = 0; square < 64; ++square) {
+    if (board_[square] != NO_PIECE)
+      key ^= pieceKey(board_[square], square);
+  }
+  if (enPassant_ != NO_SQUARE)
+    key ^= enPassantKey(enPassant_);
+  if (sideToMove_ == Color::kBlack)
+    key ^= sideKey();
+  return key;
+}
+
+Bitboard Position::attackedBy(Color color, Bitboard occupied) const {
+  Bitboard attacked = pawnAttackSet(color, pieces(color, PieceType::Pawn)) |
+                      knightAttackSet(pieces(color, PieceType::Knight)) |
+                      kingAttackSet(pieces(color, PieceType::King));
+
+  const Bitboard queens = pieces(color, PieceType::Queen);
+  Bitboard diagonal = pieces(color, PieceType::Bishop) | queens;
+  while (diagonal)
+    attacked |= bishopAttacks(popLsb(diagonal), occupied);
+  Bitboard straight = pieces(color, PieceType::Rook) | queens;
+  while (straight)
+    attacked |= rookAttacks(popLsb(straight), occupied);
+  return attacked;
+}
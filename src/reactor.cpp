@@ -0,0 +1,48 @@
+#include "reactor.h"
+
+#include <cerrno>
+
+#include <unistd.h>
+
+Reactor::Reactor() : epollFd_(::epoll_create1(EPOLL_CLOEXEC)) {}
+
+Reactor::~Reactor() {
+  if (epollFd_ >= 0)
+    ::close(epollFd_);
+}
+
+bool Reactor::add(int fd, std::uint32_t events) {
+  epoll_event event{};
+  event.events = events;
+  event.data.fd = fd;
+  return ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+bool Reactor::add(int fd, std::uint32_t events, std::uint64_t tag) {
+  epoll_event event{};
+  event.events = events;
+  event.data.u64 = tag;
+  return ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+bool Reactor::modify(int fd, std::uint32_t events) {
+  epoll_event event{};
+  event.events = events;
+  event.data.fd = fd;
+  return ::epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &event) == 0;
+}
+
+bool Reactor::remove(int fd) {
+  return ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr) == 0;
+}
+
+std::span<const epoll_event> Reactor::wait(int timeoutMs) {
+  int count;
+  do {
+    count = ::epoll_wait(epollFd_, events_.data(), static_cast<int>(events_.size()), timeoutMs);
+  } while (count < 0 && errno == EINTR);
+
+  if (count < 0)
+    return {};
+  return {events_.data(), static_cast<std::size_t>(count)};
+}
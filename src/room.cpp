@@ -0,0 +1,59 @@
+#include "room.h"
+
+#include <algorithm>
+
+RoomTable::RoomTable(std::size_t expectedRooms) {
+  rooms_.reserve(expectedRooms);
+  members_.reserve(expectedRooms);
+  index_.reserve(expectedRooms);
+}
+
+RoomTable::Slot RoomTable::open(RoomId id) {
+  if (const auto it = index_.find(id); it != index_.end())
+    return it->second;
+
+  Slot slot;
+  if (!freeSlots_.empty()) {
+    slot = freeSlots_.back();
+    freeSlots_.pop_back();
+  } else {
+    slot = static_cast<Slot>(rooms_.size());
+    rooms_.emplace_back();
+    members_.emplace_back();
+  }
+
+  Room& room = rooms_[slot];
+  room = Room{};
+  room.id = id;
+  room.position = Position::startPosition();
+  members_[slot].clear();
+  index_.emplace(id, slot);
+  return slot;
+}
+
+bool RoomTable::find(RoomId id, Slot& slot) const {
+  const auto it = index_.find(id);
+  if (it == index_.end())
+    return false;
+  slot = it->second;
+  return true;
+}
+
+void RoomTable::join(Slot slot, int member) {
+  members_[slot].push_back(member);
+}
+
+void RoomTable::leave(Slot slot, int member) {
+  Room& room = rooms_[slot];
+  for (int& player : room.players) {
+    if (player == member)
+      player = NO_PLAYER;
+  }
+
+  std::vector<int>& members = members_[slot];
+  std::erase(members, member);
+  if (members.empty()) {
+    index_.erase(room.id);
+    freeSlots_.push_back(slot);
+  }
+}
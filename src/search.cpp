@@ -0,0 +1,353 @@
+#include "search.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "game.h"
+#include "tablebase.h"
+
+static_assert(MAX_PLY < Evaluator::kMaxDepth, "the evaluator needs a state for every ply");
+
+namespace {
+
+constexpr int FIRST_SCORE = 1 << 30;
+constexpr int CAPTURE_SCORE = 1 << 24;
+constexpr int KILLER_SCORE = 1 << 22;
+constexpr int HISTORY_LIMIT = 1 << 20;
+
+// Nodes between two looks at the clock: a fraction of a millisecond, so
+// the deadline is overshot by about that much.
+constexpr std::uint64_t CLOCK_INTERVAL = 512;
+constexpr std::chrono::milliseconds DEADLINE_MARGIN{2};
+
+// Brings the best scored move still unsearched to `index`; cheaper than a
+// full sort since a cutoff usually comes from the first few moves.
+void pickNext(MoveList& moves, std::array<int, MoveList::kCapacity>& scores, std::size_t index) {
+  std::size_t best = index;
+  for (std::size_t i = index + 1; i < moves.size(); ++i) {
+    if (scores[i] > scores[best])
+      best = i;
+  }
+  std::swap(moves[index], moves[best]);
+  std::swap(scores[index], scores[best]);
+}
+
+// Mate scores are stored relative to the node rather than the root, so an
+// entry stays correct wherever in the tree the position comes up again.
+int scoreToTable(int score, int ply) {
+  if (score >= SCORE_MATE_BOUND)
+    return score + ply;
+  if (score <= -SCORE_MATE_BOUND)
+    return score - ply;
+  return score;
+}
+
+int scoreFromTable(int score, int ply) {
+  if (score >= SCORE_MATE_BOUND)
+    return score - ply;
+  if (score <= -SCORE_MATE_BOUND)
+    return score + ply;
+  return score;
+}
+
+// Exact score when the position is in a tablebase, its mates counted from
+// the root like the ones found in the tree.
+bool tablebaseScore(const Position& position, int ply, int& score) {
+  TablebaseResult result;
+  if (popCount(position.occupied()) > tablebasePieces() || !probeTablebase(position, result))
+    return false;
+  const int mate = SCORE_MATE - (ply + result.dtm);
+  score = result.wdl == Wdl::kWin ? mate : result.wdl == Wdl::kLoss ? -mate : 0;
+  return true;
+}
+
+bool isQuiet(const Position& position, Move move) {
+  return position.pieceOn(move.to()) == NO_PIECE && move.kind() != MoveKind::kEnPassant &&
+         move.kind() != MoveKind::kPromotion;
+}
+
+}  // namespace
+
+SearchResult Searcher::search(const Position& root, const SearchLimits& limits, std::span<const Key> history) {
+  const auto start = limits.start != std::chrono::steady_clock::time_point{} ? limits.start
+                                                                              : std::chrono::steady_clock::now();
+  const auto margin = std::min<std::chrono::steady_clock::duration>(limits.moveTime / 10, DEADLINE_MARGIN);
+  deadline_ = start + limits.moveTime - margin;
+  position_ = root;
+  evaluator_.reset(root);
+  keys_[0] = root.key();
+  gameKeys_ = history;
+  killers_ = {};
+  history_ = {};
+  nodes_ = 0;
+  stopped_ = false;
+  stop_ = limits.stop;
+  nodeLimit_ = limits.nodes;
+
+  SearchResult result;
+  MoveList moves;
+  generateLegalMoves(position_, moves);
+  if (moves.empty())
+    return result;
+  if (tablebaseMove(moves, result))
+    return result;
+  TableEntry entry;
+  result.best = table_.probe(root.key(), entry) && moves.contains(entry.move) ? entry.move : moves[0];
+
+  for (int depth = std::min(firstDepth_, limits.depth); depth <= std::min(limits.depth, MAX_PLY); ++depth) {
+    MoveScores scores;
+    scoreMoves(moves, scores, 0, result.best);
+
+    int alpha = -SCORE_INFINITE;
+    Move best;
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+      pickNext(moves, scores, i);
+      UndoInfo undo;
+      position_.makeMove(moves[i], undo);
+      evaluator_.push(position_, moves[i], undo);
+      keys_[1] = position_.key();
+      const int score = -alphaBeta(depth - 1, 1, -SCORE_INFINITE, -alpha);
+      evaluator_.pop();
+      position_.unmakeMove(moves[i], undo);
+      if (stopped_)
+        break;
+      if (score > alpha) {
+        alpha = score;
+        best = moves[i];
+      }
+    }
+    // The previous best is searched first, so whatever an interrupted
+    // iteration finished is at least as good as the last full one; the
+    // move being searched when time ran out is ignored. Until something
+    // finishes, result.best is the table's move or the first legal one.
+    if (stopped_) {
+      if (!best.isNull()) {
+        result.best = best;
+        result.score = alpha;
+      }
+      break;
+    }
+
+    result.best = best;
+    result.score = alpha;
+    result.depth = depth;
+    table_.store(root.key(), depth, scoreToTable(alpha, 0), Bound::kExact, best);
+    // A forced mate will not get any shorter, and the next iteration would
+    // take several times as long as everything so far.
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    if (alpha >= SCORE_MATE_BOUND || alpha <= -SCORE_MATE_BOUND || elapsed * 2 > limits.moveTime)
+      break;
+  }
+  result.nodes = nodes_;
+  return result;
+}
+
+int Searcher::alphaBeta(int depth, int ply, int alpha, int beta) {
+  const bool inCheck = isKingInCheck(position_, position_.sideToMove());
+  if (inCheck)
+    ++depth;
+  if (depth <= 0)
+    return quiescence(ply, alpha, beta);
+
+  if (shouldStop())
+    return 0;
+  ++nodes_;
+  if (isRepetition(ply))
+    return 0;
+  // The fifty-move rule does not apply when the last move mated.
+  if (position_.halfmoveClock() >= 100 && (!inCheck || hasLegalMove(position_)))
+    return 0;
+  if (int score; tablebaseScore(position_, ply, score))
+    return score;
+  if (ply >= MAX_PLY)
+    return evaluator_.evaluate(position_);
+
+  const Key key = position_.key();
+  TableEntry entry;
+  if (table_.probe(key, entry) && entry.depth >= depth) {
+    const int score = scoreFromTable(entry.score, ply);
+    if (entry.bound == Bound::kExact || (entry.bound == Bound::kLower && score >= beta) ||
+        (entry.bound == Bound::kUpper && score <= alpha))
+      return score;
+  }
+
+  MoveList moves;
+  generateLegalMoves(position_, moves);
+  if (moves.empty())
+    return inCheck ? -(SCORE_MATE - ply) : 0;
+
+  MoveScores scores;
+  scoreMoves(moves, scores, ply, entry.move);
+
+  const int us = static_cast<int>(position_.sideToMove());
+  const int originalAlpha = alpha;
+  int best = -SCORE_INFINITE;
+  Move bestMove;
+  for (std::size_t i = 0; i < moves.size(); ++i) {
+    pickNext(moves, scores, i);
+    const Move move = moves[i];
+    const bool quiet = isQuiet(position_, move);
+
+    UndoInfo undo;
+    position_.makeMove(move, undo);
+    keys_[ply + 1] = position_.key();
+    table_.prefetch(keys_[ply + 1]);
+    evaluator_.push(position_, move, undo);
+    const int score = -alphaBeta(depth - 1, ply + 1, -beta, -alpha);
+    evaluator_.pop();
+    position_.unmakeMove(move, undo);
+    if (stopped_)
+      return 0;
+
+    if (score > best) {
+      best = score;
+      bestMove = move;
+      if (score > alpha)
+        alpha = score;
+    }
+    if (alpha >= beta) {
+      if (quiet) {
+        if (killers_[ply][0] != move) {
+          killers_[ply][1] = killers_[ply][0];
+          killers_[ply][0] = move;
+        }
+        int& history = history_[us][move.from()][move.to()];
+        history += depth * depth;
+        if (history >= HISTORY_LIMIT) {
+          for (auto& from : history_[us]) {
+            for (int& value : from)
+              value /= 2;
+          }
+        }
+      }
+      break;
+    }
+  }
+
+  const Bound bound = best >= beta ? Bound::kLower : best > originalAlpha ? Bound::kExact : Bound::kUpper;
+  table_.store(key, depth, scoreToTable(best, ply), bound, bound == Bound::kUpper ? Move() : bestMove);
+  return best;
+}
+
+// Only captures and promotions are searched (every evasion when in check),
+// so the static evaluation is never taken in the middle of an exchange.
+int Searcher::quiescence(int ply, int alpha, int beta) {
+  if (shouldStop())
+    return 0;
+  ++nodes_;
+  if (int score; tablebaseScore(position_, ply, score))
+    return score;
+  if (ply >= MAX_PLY)
+    return evaluator_.evaluate(position_);
+
+  const bool inCheck = isKingInCheck(position_, position_.sideToMove());
+  int best = -SCORE_INFINITE;
+  if (!inCheck) {
+    best = evaluator_.evaluate(position_);
+    if (best >= beta)
+      return best;
+    if (best > alpha)
+      alpha = best;
+  }
+
+  MoveList moves;
+  generateLegalCaptures(position_, moves);
+  if (moves.empty())
+    return inCheck ? -(SCORE_MATE - ply) : best;
+
+  MoveScores scores;
+  scoreMoves(moves, scores, ply, Move());
+  for (std::size_t i = 0; i < moves.size(); ++i) {
+    pickNext(moves, scores, i);
+    UndoInfo undo;
+    position_.makeMove(moves[i], undo);
+    evaluator_.push(position_, moves[i], undo);
+    const int score = -quiescence(ply + 1, -beta, -alpha);
+    evaluator_.pop();
+    position_.unmakeMove(moves[i], undo);
+    if (stopped_)
+      return 0;
+
+    if (score > best) {
+      best = score;
+      if (score > alpha)
+        alpha = score;
+    }
+    if (alpha >= beta)
+      break;
+  }
+  return best;
+}
+
+bool Searcher::tablebaseMove(const MoveList& moves, SearchResult& result) {
+  if (popCount(position_.occupied()) > tablebasePieces())
+    return false;
+
+  int bestScore = -SCORE_INFINITE;
+  Move best;
+  for (const Move move : moves) {
+    UndoInfo undo;
+    position_.makeMove(move, undo);
+    int score;
+    const bool covered = tablebaseScore(position_, 1, score);
+    position_.unmakeMove(move, undo);
+    if (!covered)
+      return false;
+    if (-score > bestScore) {
+      bestScore = -score;
+      best = move;
+    }
+  }
+  result.best = best;
+  result.score = bestScore;
+  result.depth = 1;
+  result.nodes = moves.size();
+  return true;
+}
+
+void Searcher::scoreMoves(const MoveList& moves, MoveScores& scores, int ply, Move first) const {
+  const int us = static_cast<int>(position_.sideToMove());
+  for (std::size_t i = 0; i < moves.size(); ++i) {
+    const Move move = moves[i];
+    const PieceCode victim = position_.pieceOn(move.to());
+    int score;
+    if (move == first) {
+      score = FIRST_SCORE;
+    } else if (victim != NO_PIECE || move.kind() == MoveKind::kEnPassant ||
+               move.kind() == MoveKind::kPromotion) {
+      const int victimValue = victim != NO_PIECE ? PIECE_VALUES[static_cast<int>(pieceType(victim))]
+                              : move.kind() == MoveKind::kEnPassant ? PIECE_VALUES[static_cast<int>(PieceType::Pawn)]
+                                                                    : 0;
+      const int promotionValue =
+          move.kind() == MoveKind::kPromotion ? PIECE_VALUES[static_cast<int>(move.promotion())] : 0;
+      const int attackerValue = PIECE_VALUES[static_cast<int>(pieceType(position_.pieceOn(move.from())))];
+      score = CAPTURE_SCORE + (victimValue + promotionValue) * 16 - attackerValue;
+    } else if (move == killers_[ply][0]) {
+      score = KILLER_SCORE + 1;
+    } else if (move == killers_[ply][1]) {
+      score = KILLER_SCORE;
+    } else {
+      score = history_[us][move.from()][move.to()];
+    }
+    scores[i] = score;
+  }
+}
+
+bool Searcher::isRepetition(int ply) const {
+  // Negative plies are the game's positions before the root.
+  const int earliest = std::max(ply - position_.halfmoveClock(), -static_cast<int>(gameKeys_.size()));
+  for (int i = ply - 4; i >= earliest; i -= 2) {
+    const Key key = i >= 0 ? keys_[i] : gameKeys_[gameKeys_.size() + i];
+    if (key == keys_[ply])
+      return true;
+  }
+  return false;
+}
+
+bool Searcher::shouldStop() {
+  if (!stopped_ && nodes_ % CLOCK_INTERVAL == 0 &&
+      ((stop_ && stop_->load(std::memory_order_relaxed)) || (nodeLimit_ != 0 && nodes_ >= nodeLimit_) ||
+       std::chrono::steady_clock::now() >= deadline_))
+    stopped_ = true;
+  return stopped_;
+}
@@ -0,0 +1,83 @@
+#include "search_pool.h"
+
+#include <algorithm>
+#include <chrono>
+
+SearchPool::SearchPool(TranspositionTable& table, std::size_t threadCount)
+    : table_(table), results_(std::max<std::size_t>(1, threadCount)) {
+  for (std::size_t i = 0; i < results_.size(); ++i)
+    searchers_.push_back(std::make_unique<Searcher>(table_, 1 + static_cast<int>(i % 2)));
+  for (std::size_t i = 1; i < searchers_.size(); ++i)
+    helpers_.emplace_back([this, i] { helperLoop(i); });
+}
+
+SearchPool::~SearchPool() {
+  {
+    std::lock_guard lock(mutex_);
+    quit_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread& helper : helpers_)
+    helper.join();
+}
+
+SearchResult SearchPool::search(const Position& root, const SearchLimits& limits, std::span<const Key> history) {
+  table_.newSearch();
+
+  if (!helpers_.empty()) {
+    std::lock_guard lock(mutex_);
+    root_ = root;
+    history_ = history;
+    // Helpers run until the main thread is done, whatever the limits say.
+    helperLimits_ = {MAX_PLY, std::chrono::hours(24), 0, &stopHelpers_};
+    stopHelpers_.store(false, std::memory_order_relaxed);
+    busyHelpers_ = helpers_.size();
+    ++job_;
+  }
+  wake_.notify_all();
+
+  results_[0] = searchers_[0]->search(root, limits, history);
+
+  if (!helpers_.empty()) {
+    stopHelpers_.store(true, std::memory_order_relaxed);
+    std::unique_lock lock(mutex_);
+    finished_.wait(lock, [this] { return busyHelpers_ == 0; });
+  }
+
+  SearchResult best = results_[0];
+  std::uint64_t nodes = 0;
+  for (const SearchResult& result : results_) {
+    nodes += result.nodes;
+    if (result.depth > best.depth && !result.best.isNull())
+      best = result;
+  }
+  best.nodes = nodes;
+  return best;
+}
+
+void SearchPool::helperLoop(std::size_t index) {
+  std::uint64_t seen = 0;
+  while (true) {
+    Position root;
+    SearchLimits limits;
+    std::span<const Key> history;
+    {
+      std::unique_lock lock(mutex_);
+      wake_.wait(lock, [&] { return quit_ || job_ != seen; });
+      if (quit_)
+        return;
+      seen = job_;
+      root = root_;
+      limits = helperLimits_;
+      history = history_;
+    }
+
+    results_[index] = searchers_[index]->search(root, limits, history);
+
+    {
+      std::lock_guard lock(mutex_);
+      --busyHelpers_;
+    }
+    finished_.notify_one();
+  }
+}
@@ -0,0 +1,661 @@
+#include "shard.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <iostream>
+
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "game.h"
+#include "net.h"
+#include "protocol.h"
+#include "tablebase.h"
+
+namespace {
+
+// epoll data and io_uring user_data: what the event is for in the top
+// byte, the connection it concerns below.
+enum EventKind : std::uint64_t { kConnectionEvent, kWakeEvent, kReceiveEvent, kSendEvent };
+
+constexpr unsigned EVENT_KIND_SHIFT = 56;
+
+std::uint64_t eventTag(EventKind kind, ConnectionId id) {
+  return (static_cast<std::uint64_t>(kind) << EVENT_KIND_SHIFT) | id;
+}
+
+EventKind eventKind(std::uint64_t tag) {
+  return static_cast<EventKind>(tag >> EVENT_KIND_SHIFT);
+}
+
+ConnectionId eventConnection(std::uint64_t tag) {
+  return tag & ((std::uint64_t{1} << EVENT_KIND_SHIFT) - 1);
+}
+
+}  // namespace
+
+Shard::Shard(BotEngine& engine, std::size_t sendLimit, IoBackend backend)
+    : wakeFd_(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), sendLimit_(sendLimit), engine_(engine) {
+  if (backend == IoBackend::kIoUring) {
+    ring_ = std::make_unique<IoRing>(kRingEntries, kReceiveBuffers, kReceiveBufferSize);
+    if (!ring_->isValid())
+      ring_.reset();
+  }
+}
+
+Shard::~Shard() {
+  stop();
+  for (const Connection& connection : connections_.slots()) {
+    if (connection.socket >= 0)
+      closeSocket(connection.socket);
+  }
+  if (wakeFd_ >= 0)
+    ::close(wakeFd_);
+}
+
+bool Shard::start(int cpu) {
+  if (!reactor_.isValid() || wakeFd_ < 0 || !reactor_.add(wakeFd_, EPOLLIN | EPOLLET, eventTag(kWakeEvent, 0)))
+    return false;
+
+  running_.store(true, std::memory_order_release);
+  thread_ = std::thread([this] { run(); });
+
+  if (cpu >= 0) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    ::pthread_setaffinity_np(thread_.native_handle(), sizeof(cpus), &cpus);
+  }
+  return true;
+}
+
+void Shard::stop() {
+  if (!thread_.joinable())
+    return;
+  running_.store(false, std::memory_order_release);
+  wake();
+  thread_.join();
+}
+
+bool Shard::post(Handoff&& handoff) {
+  if (!inbox_.push(std::move(handoff)))
+    return false;
+  wake();
+  return true;
+}
+
+OutboundStats Shard::outboundStats() const {
+  return {queuedBytes_.load(std::memory_order_relaxed), peakQueuedBytes_.load(std::memory_order_relaxed),
+          slowDisconnects_.load(std::memory_order_relaxed)};
+}
+
+void Shard::wake() {
+  const std::uint64_t one = 1;
+  [[maybe_unused]] const auto written = ::write(wakeFd_, &one, sizeof(one));
+}
+
+void Shard::run() {
+  if (ring_) {
+    runRing();
+    return;
+  }
+  while (running_.load(std::memory_order_acquire)) {
+    for (const epoll_event& event : reactor_.wait(-1)) {
+      if (eventKind(event.data.u64) == kWakeEvent) {
+        drainInbox();
+        continue;
+      }
+      // The connection may have been closed earlier in this batch.
+      Index connection;
+      if (!connections_.find(eventConnection(event.data.u64), connection))
+        continue;
+      if (event.events & EPOLLOUT)
+        flushOutbound(connection);
+      if (event.events & ~EPOLLOUT)
+        receiveFrom(connection);
+    }
+    flushUnflushed();
+    closePending();
+  }
+}
+
+void Shard::drainInbox() {
+  std::uint64_t count;
+  while (::read(wakeFd_, &count, sizeof(count)) > 0) {
+  }
+
+  Handoff handoff;
+  while (inbox_.pop(handoff)) {
+    adopt(handoff);
+  }
+  BotReply reply;
+  while (botReplies_.pop(reply)) {
+    applyBotMove(reply);
+  }
+}
+
+void Shard::adopt(Handoff& handoff) {
+  const int socket = handoff.socket;
+  const Index index = connections_.open(socket);
+  // EPOLLOUT stays registered: edge-triggered, it only fires when a full
+  // socket drains, which is exactly when a queued backlog can move on.
+  if (!ring_ && !reactor_.add(socket, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET,
+                              eventTag(kConnectionEvent, connections_.id(index)))) {
+    closeSocket(socket);
+    connections_.release(index);
+    return;
+  }
+
+  const RoomTable::Slot slot = rooms_.open(handoff.room);
+  Room& room = rooms_[slot];
+  const int member = static_cast<int>(index);
+  rooms_.join(slot, member);
+
+  if ((handoff.joinFlags & JOIN_FLAG_BOT) && room.players[0] == NO_PLAYER && room.players[1] == NO_PLAYER)
+    room.players[1] = BOT_PLAYER;
+
+  std::uint8_t role = ROLE_SPECTATOR;
+  if (room.players[0] == NO_PLAYER) {
+    room.players[0] = member;
+    role = ROLE_PA;
+  } else if (room.players[1] == NO_PLAYER) {
+    room.players[1] = member;
+    role = ROLE_PB;
+  }
+
+  // Frames that followed JOIN in the acceptor's read come along.
+  Connection& connection = connections_[index];
+  connection.session = Session{slot, role};
+  connection.receiveBuffer = *handoff.buffer;
+  if (ring_)
+    armReceive(index);
+
+  std::string roleMessage;
+  appendFrame(roleMessage, encodeRole({PROTOCOL_VERSION, role, handoff.room}));
+  appendFrame(roleMessage, encodePosition({room.position.key()}));
+  send(index, makeShared(std::move(roleMessage)));
+
+  if (!isClosing(index))
+    handleFrames(index);
+}
+
+void Shard::receiveFrom(Index index) {
+  if (isClosing(index))
+    return;
+
+  // Edge-triggered: drain the socket, otherwise we are never woken again.
+  Connection& connection = connections_[index];
+  while (true) {
+    const std::span<char> free = connection.receiveBuffer.writable();
+    const ssize_t received = ::recv(connection.socket, free.data(), free.size(), 0);
+    if (received > 0) {
+      connection.receiveBuffer.commit(static_cast<std::size_t>(received));
+      connection.bytesReceived += static_cast<std::size_t>(received);
+      if (!handleFrames(index))
+        return;
+      continue;
+    }
+    if (received < 0 && errno == EINTR)
+      continue;
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return;
+    if (received < 0 && errno != ECONNRESET)
+      std::cerr << "Error receiving\n";
+    disconnect(index);
+    return;
+  }
+}
+
+bool Shard::handleFrames(Index index) {
+  FrameBuffer& buffer = connections_[index].receiveBuffer;
+  std::string_view payload;
+  FrameStatus frameStatus;
+  while ((frameStatus = buffer.nextFrame(payload)) == FrameStatus::kReady) {
+    handleMessage(index, payload);
+    if (isClosing(index))
+      return false;
+  }
+  if (frameStatus == FrameStatus::kInvalid) {
+    std::cerr << "Invalid frame, closing connection\n";
+    disconnect(index);
+    return false;
+  }
+  return true;
+}
+
+void Shard::handleMessage(Index index, std::string_view payload) {
+  Opcode opcode;
+  if (!peekOpcode(payload, opcode))
+    return;
+
+  // JOIN is handled by the acceptor; a connection stays in its room.
+  const Session& session = connections_[index].session;
+  if (opcode == Opcode::kMove) {
+    handleMove(session, payload);
+  } else if (opcode == Opcode::kHint && decodeHintRequest(payload)) {
+    handleHint(index, session);
+  }
+}
+
+void Shard::handleHint(Index index, const Session& session) {
+  HintRecord hint;
+  if (const OpeningBook* book = engine_.options().book) {
+    std::array<BookMove, HINT_MOVES> moves;
+    const std::size_t count = book->probe(rooms_[session.room].position, moves);
+    for (std::size_t i = 0; i < count; ++i) {
+      const Move move = moves[i].move;
+      hint.moves[i] = {static_cast<std::uint8_t>(move.from()), static_cast<std::uint8_t>(move.to()),
+                       move.kind() == MoveKind::kPromotion ? static_cast<std::uint8_t>(move.promotion())
+                                                           : NO_PROMOTION};
+    }
+    hint.count = static_cast<std::uint8_t>(count);
+  }
+
+  std::string message;
+  appendFrame(message, encodeHint(hint));
+  send(index, makeShared(std::move(message)));
+}
+
+void Shard::handleMove(const Session& session, std::string_view payload) {
+  if (session.role == ROLE_SPECTATOR)
+    return;
+
+  Room& room = rooms_[session.room];
+  Position& position = room.position;
+
+  MoveRecord request;
+  if (!decodeMove(payload, request)) {
+    std::cerr << "Error : malformed move\n";
+    return;
+  }
+
+  Color playerColor = (session.role == ROLE_PA) ? Color::kWhite : Color::kBlack;
+
+  if (!room.isFull() || room.over) {
+    std::cerr << "Error\n";
+    return;
+  }
+
+  if (position.sideToMove() != playerColor || position.colorOn(request.from) != playerColor) {
+    std::cerr << "Error\n";
+    return;
+  }
+
+  // The move is played in place and only taken back if it leaves the
+  // player's own king in check.
+  const Move move = moveFromWire(position, request.from, request.to, request.promotion);
+  if (!isMoveValid(position, move)) {
+    std::cerr << "Error\n";
+    return;
+  }
+
+  const PieceCode movingPiece = position.pieceOn(move.from());
+  const Key previous = position.key();
+  UndoInfo undo;
+  position.makeMove(move, undo);
+  if (isKingInCheck(position, playerColor)) {
+    position.unmakeMove(move, undo);
+    std::cerr << "Error\n";
+    return;
+  }
+  room.recordMove(previous);
+
+  announceMove(session.room, session.role, move, movingPiece, undo.captured);
+  if (room.hasBot())
+    playBotMove(session.room);
+}
+
+void Shard::announceMove(RoomTable::Slot slot, std::uint8_t role, Move move, PieceCode movingPiece,
+                         PieceCode capturedPiece) {
+  Room& room = rooms_[slot];
+  const Position& position = room.position;
+  const Color playerColor = pieceColor(movingPiece);
+  const Color opponentColor = opposite(playerColor);
+
+  MoveRecord moved;
+  moved.role = role;
+  moved.piece = static_cast<std::uint8_t>(pieceType(movingPiece));
+  moved.from = static_cast<std::uint8_t>(move.from());
+  moved.to = static_cast<std::uint8_t>(move.to());
+  if (move.kind() == MoveKind::kPromotion)
+    moved.promotion = static_cast<std::uint8_t>(move.promotion());
+  if (capturedPiece != NO_PIECE)
+    moved.flags |= MOVE_FLAG_CAPTURE;
+  if (isKingInCheck(position, opponentColor))
+    moved.flags |= MOVE_FLAG_CHECK;
+
+  // MOVE, CAPTURE, POSITION and CHECKMATE go out together in a single write.
+  std::string outgoing;
+  appendFrame(outgoing, encodeMove(moved));
+
+  // Castling moves the rook too; clients see it as a second MOVE.
+  if (move.kind() == MoveKind::kCastling) {
+    MoveRecord rook;
+    rook.role = role;
+    rook.piece = static_cast<std::uint8_t>(PieceType::Rook);
+    rook.from = static_cast<std::uint8_t>(castlingRookFrom(move.to()));
+    rook.to = static_cast<std::uint8_t>(castlingRookTo(move.to()));
+    appendFrame(outgoing, encodeMove(rook));
+  }
+
+  // Si une pièce a été capturée, envoie aussi un message de capture
+  if (capturedPiece != NO_PIECE) {
+    CaptureRecord capture;
+    capture.role = (pieceColor(capturedPiece) == Color::kWhite) ? ROLE_PA : ROLE_PB;
+    capture.piece = static_cast<std::uint8_t>(pieceType(capturedPiece));
+    capture.square = static_cast<std::uint8_t>(captureSquare(move, playerColor));
+    appendFrame(outgoing, encodeCapture(capture));
+  }
+
+  appendFrame(outgoing, encodePosition({position.key()}));
+
+  if (isCheckmate(position, opponentColor)) {
+    appendFrame(outgoing, encodeCheckmate({role}));
+    room.over = true;
+    std::cout << "echec et mat : room " << room.id << "\n";
+  } else if (isStalemate(position, opponentColor)) {
+    appendFrame(outgoing, encodeStalemate());
+    room.over = true;
+    std::cout << "pat : room " << room.id << "\n";
+  } else if (engine_.options().tablebaseAdjudication && popCount(position.occupied()) <= tablebasePieces()) {
+    // The position still has legal moves, so only the flag ends the game.
+    TablebaseResult result;
+    if (probeTablebase(position, result) && result.wdl == Wdl::kDraw) {
+      appendFrame(outgoing, encodeStalemate());
+      room.over = true;
+      std::cout << "nulle (tables) : room " << room.id << "\n";
+    }
+  }
+
+  // Encoded once; every member's queue holds a reference to the same bytes.
+  broadcast(slot, makeShared(std::move(outgoing)));
+}
+
+void Shard::playBotMove(RoomTable::Slot slot) {
+  const Room& room = rooms_[slot];
+  if (room.over || room.position.sideToMove() != Color::kBlack)
+    return;
+
+  const RoomId id = room.id;
+  const Key key = room.position.key();
+  engine_.play(id, room.position, room.keyHistory, [this, id, key](Move move) {
+    // The queue only fills up if the loop is that far behind; wait for it,
+    // unless the loop has stopped and will never drain it.
+    while (!botReplies_.push(BotReply{id, key, move})) {
+      if (!running_.load(std::memory_order_acquire))
+        return;
+      std::this_thread::yield();
+    }
+    wake();
+  });
+}
+
+void Shard::applyBotMove(const BotReply& reply) {
+  RoomTable::Slot slot;
+  if (reply.move.isNull() || !rooms_.find(reply.room, slot))
+    return;
+  Room& room = rooms_[slot];
+  Position& position = room.position;
+  if (!room.hasBot() || room.over || position.key() != reply.key)
+    return;
+
+  const PieceCode movingPiece = position.pieceOn(reply.move.from());
+  UndoInfo undo;
+  position.makeMove(reply.move, undo);
+  room.recordMove(reply.key);
+  announceMove(slot, ROLE_PB, reply.move, movingPiece, undo.captured);
+}
+
+void Shard::broadcast(RoomTable::Slot slot, const SharedBytes& message) {
+  for (const int member : rooms_.members(slot)) {
+    send(static_cast<Index>(member), message);
+  }
+}
+
+void Shard::send(Index index, const SharedBytes& data) {
+  Connection& connection = connections_[index];
+  if (isClosing(index))
+    return;
+
+  OutboundBuffer& buffer = connection.sendBuffer;
+  const std::size_t before = buffer.size();
+  buffer.append(data);
+  accountQueued(before, buffer.size());
+  // With bytes already queued a flush is under way: EPOLLOUT or the
+  // completion of the send in flight picks these up.
+  if (before == 0)
+    unflushed_.push_back(connections_.id(index));
+
+  // Game events cannot be skipped without desynchronising the client, so
+  // a consumer that falls this far behind is shed rather than trimmed.
+  if (buffer.size() > sendLimit_) {
+    std::cerr << "Client trop lent (" << buffer.size() << " octets en attente, " << connection.bytesSent
+              << " envoyes), deconnexion\n";
+    slowDisconnects_.store(slowDisconnects_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    closeLater(index);
+  }
+}
+
+void Shard::flushUnflushed() {
+  for (const ConnectionId id : unflushed_) {
+    Index index;
+    if (connections_.find(id, index))
+      flushOutbound(index);
+  }
+  unflushed_.clear();
+}
+
+void Shard::flushOutbound(Index index) {
+  Connection& connection = connections_[index];
+  if (connection.sendBuffer.empty() || isClosing(index))
+    return;
+
+  if (ring_) {
+    if (!connection.ring.sending)
+      submitSend(index);
+    return;
+  }
+  OutboundBuffer& buffer = connection.sendBuffer;
+  const std::size_t before = buffer.size();
+  const FlushStatus status = buffer.flush(connection.socket);
+  connection.bytesSent += before - buffer.size();
+  accountQueued(before, buffer.size());
+  if (status == FlushStatus::kError)
+    closeLater(index);
+}
+
+void Shard::accountQueued(std::size_t before, std::size_t after) {
+  queuedBytes_.store(queuedBytes_.load(std::memory_order_relaxed) + after - before, std::memory_order_relaxed);
+  if (after > peakQueuedBytes_.load(std::memory_order_relaxed))
+    peakQueuedBytes_.store(after, std::memory_order_relaxed);
+}
+
+void Shard::closeLater(Index index) {
+  Connection& connection = connections_[index];
+  if (connection.closing)
+    return;
+  connection.closing = true;
+  closing_.push_back(connections_.id(index));
+}
+
+void Shard::closePending() {
+  for (const ConnectionId id : closing_) {
+    Index index;
+    if (connections_.find(id, index))
+      disconnect(index);
+  }
+  closing_.clear();
+}
+
+void Shard::disconnect(Index index) {
+  Connection& connection = connections_[index];
+  if (!connection.closed) {
+    connection.closed = true;
+    rooms_.leave(connection.session.room, static_cast<int>(index));
+  }
+  if (connection.ring.receiving || connection.ring.sending) {
+    // Out of the game now; shutdown() completes what is in flight, and
+    // releaseIfIdle() comes back here once the last completion is in.
+    ::shutdown(connection.socket, SHUT_RDWR);
+    return;
+  }
+
+  closeSocket(connection.socket);
+  accountQueued(connection.sendBuffer.size(), 0);
+  connections_.release(index);
+}
+
+void Shard::runRing() {
+  armWake();
+  while (running_.load(std::memory_order_acquire)) {
+    if (!ring_->submitAndWait()) {
+      std::cerr << "Error : io_uring_enter\n";
+      return;
+    }
+    ring_->forEachCompletion([this](const io_uring_cqe& cqe) { handleCompletion(cqe); });
+    flushUnflushed();
+    closePending();
+  }
+}
+
+void Shard::handleCompletion(const io_uring_cqe& cqe) {
+  const EventKind kind = eventKind(cqe.user_data);
+  if (kind == kWakeEvent) {
+    drainInbox();
+    if (!(cqe.flags & IORING_CQE_F_MORE))
+      armWake();
+    return;
+  }
+
+  // A slot is only released once its last request has completed, so this
+  // always resolves; the check guards against a stray completion.
+  Index index;
+  if (!connections_.find(eventConnection(cqe.user_data), index)) {
+    if (cqe.flags & IORING_CQE_F_BUFFER)
+      ring_->recycle(static_cast<std::uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+    return;
+  }
+  if (kind == kReceiveEvent)
+    completeReceive(index, cqe);
+  else if (kind == kSendEvent)
+    completeSend(index, cqe.res);
+}
+
+void Shard::completeReceive(Index index, const io_uring_cqe& cqe) {
+  Connection& connection = connections_[index];
+  const bool hasBuffer = cqe.flags & IORING_CQE_F_BUFFER;
+  const auto bufferId = static_cast<std::uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+
+  // Still flagged as receiving while the frames are handled, so that a
+  // disconnect from in there keeps the slot.
+  if (cqe.res > 0 && hasBuffer && !isClosing(index)) {
+    connection.bytesReceived += static_cast<std::size_t>(cqe.res);
+    FrameBuffer& frames = connection.receiveBuffer;
+    std::span<const char> bytes = ring_->buffer(bufferId, static_cast<std::size_t>(cqe.res));
+    while (!bytes.empty()) {
+      const std::span<char> free = frames.writable();
+      const std::size_t count = std::min(free.size(), bytes.size());
+      std::copy_n(bytes.data(), count, free.data());
+      frames.commit(count);
+      bytes = bytes.subspan(count);
+      if (!handleFrames(index))
+        break;
+    }
+  }
+  if (hasBuffer)
+    ring_->recycle(bufferId);
+
+  if (cqe.flags & IORING_CQE_F_MORE)
+    return;
+  connection.ring.receiving = false;
+  if (isClosing(index)) {
+    releaseIfIdle(index);
+  } else if (cqe.res > 0 || cqe.res == -ENOBUFS) {
+    // The multishot receive ended without the connection ending (the
+    // buffer pool ran dry, for one): arm it again.
+    armReceive(index);
+  } else {
+    if (cqe.res < 0 && cqe.res != -ECONNRESET)
+      std::cerr << "Error receiving\n";
+    disconnect(index);
+  }
+}
+
+void Shard::completeSend(Index index, int result) {
+  Connection& connection = connections_[index];
+  connection.ring.sending = false;
+  if (connection.closed) {
+    releaseIfIdle(index);
+    return;
+  }
+  if (result < 0) {
+    closeLater(index);
+    return;
+  }
+
+  OutboundBuffer& buffer = connection.sendBuffer;
+  const std::size_t before = buffer.size();
+  buffer.consume(static_cast<std::size_t>(result));
+  connection.bytesSent += static_cast<std::size_t>(result);
+  accountQueued(before, buffer.size());
+  if (!buffer.empty() && !isClosing(index))
+    submitSend(index);
+}
+
+void Shard::armWake() {
+  io_uring_sqe* sqe = ring_->nextEntry();
+  if (!sqe) {
+    std::cerr << "Error : io_uring submission queue\n";
+    return;
+  }
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = wakeFd_;
+  sqe->poll32_events = POLLIN;
+  sqe->len = IORING_POLL_ADD_MULTI;
+  sqe->user_data = eventTag(kWakeEvent, 0);
+}
+
+void Shard::armReceive(Index index) {
+  io_uring_sqe* sqe = ring_->nextEntry();
+  if (!sqe) {
+    closeLater(index);
+    return;
+  }
+  Connection& connection = connections_[index];
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = connection.socket;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = IoRing::kBufferGroup;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->user_data = eventTag(kReceiveEvent, connections_.id(index));
+  connection.ring.receiving = true;
+}
+
+void Shard::submitSend(Index index) {
+  // A single SENDMSG per connection at a time keeps the byte stream in
+  // order; linked sends would not survive a short write.
+  io_uring_sqe* sqe = ring_->nextEntry();
+  if (!sqe) {
+    closeLater(index);
+    return;
+  }
+  Connection& connection = connections_[index];
+  sqe->opcode = IORING_OP_SENDMSG;
+  sqe->fd = connection.socket;
+  sqe->addr = reinterpret_cast<std::uint64_t>(connection.sendBuffer.prepare());
+  sqe->len = 1;
+  sqe->msg_flags = MSG_NOSIGNAL;
+  sqe->user_data = eventTag(kSendEvent, connections_.id(index));
+  connection.ring.sending = true;
+}
+
+void Shard::releaseIfIdle(Index index) {
+  // A connection that is only closing is still queued in closing_.
+  const Connection& connection = connections_[index];
+  if (connection.closed && !connection.ring.receiving && !connection.ring.sending)
+    disconnect(index);
+}
@@ -0,0 +1,271 @@
+#include "tablebase.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::string_view PIECE_LETTERS = "KQRBNP";
+
+using PieceCounts = std::array<int, 2 * PIECE_TYPE_COUNT>;
+
+// A mapped table; files stay mapped for the life of the process.
+struct Table {
+  void* mapped = nullptr;
+  std::size_t size = 0;
+  Material material;
+  std::uint64_t blockCount = 0;
+  const unsigned char* offsets = nullptr;
+  const unsigned char* payload = nullptr;
+};
+
+struct TableRef {
+  std::size_t table;
+  bool flipped;
+};
+
+std::vector<Table> TABLES;
+std::unordered_map<std::uint64_t, TableRef> TABLE_INDEX;
+int MAX_PIECES = 0;
+
+template <typename T>
+T readLittleEndian(const unsigned char* bytes) {
+  static_assert(std::endian::native == std::endian::little, "tablebase files are little-endian");
+  T value;
+  std::memcpy(&value, bytes, sizeof(T));
+  return value;
+}
+
+// White is the side with more queens, or with as many queens and more
+// rooks, and so on down to pawns; equal material stays as it is.
+Material canonicalMaterial(const PieceCounts& counts, bool& flipped) {
+  flipped = false;
+  for (int type = static_cast<int>(PieceType::Queen); type < PIECE_TYPE_COUNT; ++type) {
+    const int white = counts[type];
+    const int black = counts[PIECE_TYPE_COUNT + type];
+    if (white != black) {
+      flipped = black > white;
+      break;
+    }
+  }
+
+  Material material;
+  for (const Color side : {Color::kWhite, Color::kBlack}) {
+    const Color from = flipped ? opposite(side) : side;
+    for (int type = 0; type < PIECE_TYPE_COUNT; ++type) {
+      for (int n = counts[makePiece(from, static_cast<PieceType>(type))];
+           n > 0 && material.count < TABLEBASE_MAX_PIECES; --n)
+        material.pieces[material.count++] = makePiece(side, static_cast<PieceType>(type));
+    }
+  }
+  return material;
+}
+
+// The same counts with the colors swapped.
+std::uint64_t flippedKey(std::uint64_t key) {
+  constexpr int kSideBits = 4 * PIECE_TYPE_COUNT;
+  return (key >> kSideBits) | ((key & ((std::uint64_t{1} << kSideBits) - 1)) << kSideBits);
+}
+
+bool mapTable(const std::filesystem::path& path, Table& table) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+
+  struct stat info {};
+  void* mapped = MAP_FAILED;
+  if (::fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) > TABLEBASE_HEADER_SIZE)
+    mapped = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED)
+    return false;
+
+  const auto* bytes = static_cast<const unsigned char*>(mapped);
+  const auto size = static_cast<std::size_t>(info.st_size);
+  table.material.count = static_cast<int>(readLittleEndian<std::uint32_t>(bytes + 8));
+  table.blockCount = readLittleEndian<std::uint64_t>(bytes + 16);
+  bool valid = readLittleEndian<std::uint32_t>(bytes) == TABLEBASE_MAGIC &&
+               readLittleEndian<std::uint32_t>(bytes + 4) == TABLEBASE_VERSION &&
+               readLittleEndian<std::uint32_t>(bytes + 12) == TABLEBASE_BLOCK_ENTRIES &&
+               table.material.count > 2 && table.material.count <= TABLEBASE_MAX_PIECES;
+  if (valid) {
+    for (int i = 0; i < table.material.count; ++i)
+      table.material.pieces[i] = std::min<PieceCode>(bytes[24 + i], NO_PIECE);
+    // Only canonical signatures are looked up.
+    Material canonical;
+    valid = parseMaterial(materialName(table.material), canonical) && canonical.pieces == table.material.pieces;
+  }
+  if (valid) {
+    const std::uint64_t entries = tablebaseEntries(table.material);
+    const std::size_t indexSize = (table.blockCount + 1) * sizeof(std::uint64_t);
+    valid = table.blockCount == (entries + TABLEBASE_BLOCK_ENTRIES - 1) / TABLEBASE_BLOCK_ENTRIES &&
+            TABLEBASE_HEADER_SIZE + indexSize <= size;
+    if (valid) {
+      table.offsets = bytes + TABLEBASE_HEADER_SIZE;
+      table.payload = table.offsets + indexSize;
+      valid = readLittleEndian<std::uint64_t>(table.offsets + table.blockCount * sizeof(std::uint64_t)) ==
+              size - TABLEBASE_HEADER_SIZE - indexSize;
+    }
+  }
+  if (!valid) {
+    ::munmap(mapped, size);
+    return false;
+  }
+
+  // A probe touches one index entry and one block; readahead would only
+  // waste memory.
+  ::madvise(mapped, size, MADV_RANDOM);
+  table.mapped = mapped;
+  table.size = size;
+  return true;
+}
+
+std::uint8_t entryAt(const Table& table, std::uint64_t index) {
+  const std::uint64_t block = index / TABLEBASE_BLOCK_ENTRIES;
+  const unsigned char* run =
+      table.payload + readLittleEndian<std::uint64_t>(table.offsets + block * sizeof(std::uint64_t));
+  std::size_t skip = index % TABLEBASE_BLOCK_ENTRIES;
+  while (skip >= run[0]) {
+    skip -= run[0];
+    run += 2;
+  }
+  return run[1];
+}
+
+}  // namespace
+
+bool parseMaterial(std::string_view name, Material& material) {
+  const std::size_t separator = name.find('v');
+  if (separator == std::string_view::npos)
+    return false;
+
+  PieceCounts counts{};
+  int total = 0;
+  for (const Color side : {Color::kWhite, Color::kBlack}) {
+    const std::string_view letters = side == Color::kWhite ? name.substr(0, separator) : name.substr(separator + 1);
+    if (letters.empty() || letters.front() != 'K')
+      return false;
+    for (std::size_t i = 0; i < letters.size(); ++i) {
+      const std::size_t type = PIECE_LETTERS.find(letters[i]);
+      if (type == std::string_view::npos || (type == 0) != (i == 0))
+        return false;
+      ++counts[makePiece(side, static_cast<PieceType>(type))];
+      ++total;
+    }
+  }
+  if (total > TABLEBASE_MAX_PIECES)
+    return false;
+
+  bool flipped;
+  material = canonicalMaterial(counts, flipped);
+  return true;
+}
+
+std::string materialName(const Material& material) {
+  std::string name;
+  for (int i = 0; i < material.count; ++i) {
+    if (i > 0 && pieceType(material.pieces[i]) == PieceType::King)
+      name += 'v';
+    name += PIECE_LETTERS[static_cast<int>(pieceType(material.pieces[i]))];
+  }
+  return name;
+}
+
+std::uint64_t materialKey(const Material& material) {
+  std::uint64_t key = 0;
+  for (int i = 0; i < material.count; ++i)
+    key += std::uint64_t{1} << (4 * material.pieces[i]);
+  return key;
+}
+
+std::uint64_t materialKey(const Position& position) {
+  std::uint64_t key = 0;
+  for (PieceCode piece = 0; piece < 2 * PIECE_TYPE_COUNT; ++piece)
+    key += static_cast<std::uint64_t>(popCount(position.pieces(pieceColor(piece), pieceType(piece))))
+           << (4 * piece);
+  return key;
+}
+
+Material materialOf(const Position& position, bool& flipped) {
+  PieceCounts counts{};
+  for (PieceCode piece = 0; piece < 2 * PIECE_TYPE_COUNT; ++piece)
+    counts[piece] = popCount(position.pieces(pieceColor(piece), pieceType(piece)));
+  return canonicalMaterial(counts, flipped);
+}
+
+std::uint64_t tablebaseIndex(const Material& material, const Position& position, bool flipped) {
+  // Pieces of the same kind fill their slots in square order.
+  std::array<Bitboard, 2 * PIECE_TYPE_COUNT> left{};
+  for (int i = 0; i < material.count; ++i) {
+    const PieceCode piece = material.pieces[i];
+    const Color color = flipped ? opposite(pieceColor(piece)) : pieceColor(piece);
+    left[piece] = position.pieces(color, pieceType(piece));
+  }
+
+  std::array<Square, TABLEBASE_MAX_PIECES> squares{};
+  for (int i = 0; i < material.count; ++i) {
+    const Square square = popLsb(left[material.pieces[i]]);
+    squares[i] = flipped ? square ^ 56 : square;
+  }
+
+  const Color sideToMove = flipped ? opposite(position.sideToMove()) : position.sideToMove();
+  std::uint64_t index = static_cast<std::uint64_t>(sideToMove);
+  for (int i = material.count - 1; i >= 0; --i)
+    index = (index << 6) | static_cast<std::uint64_t>(squares[i]);
+  return index;
+}
+
+std::size_t loadTablebases(const char* directory) {
+  std::error_code error;
+  std::size_t loaded = 0;
+  for (const auto& file : std::filesystem::directory_iterator(directory, error)) {
+    if (file.path().extension() != ".tb")
+      continue;
+    Table table;
+    if (!mapTable(file.path(), table))
+      continue;
+
+    const std::uint64_t key = materialKey(table.material);
+    if (TABLE_INDEX.contains(key)) {
+      ::munmap(table.mapped, table.size);
+      continue;
+    }
+    TABLE_INDEX[key] = {TABLES.size(), false};
+    if (flippedKey(key) != key)
+      TABLE_INDEX[flippedKey(key)] = {TABLES.size(), true};
+    MAX_PIECES = std::max(MAX_PIECES, table.material.count);
+    TABLES.push_back(table);
+    ++loaded;
+  }
+  return loaded;
+}
+
+int tablebasePieces() {
+  return MAX_PIECES;
+}
+
+bool probeTablebase(const Position& position, TablebaseResult& result) {
+  const int pieces = popCount(position.occupied());
+  if (pieces == 2) {
+    result = {};
+    return true;
+  }
+  if (pieces > MAX_PIECES || position.castlingRights() != 0 || position.enPassantSquare() != NO_SQUARE)
+    return false;
+
+  const auto it = TABLE_INDEX.find(materialKey(position));
+  if (it == TABLE_INDEX.end())
+    return false;
+  const Table& table = TABLES[it->second.table];
+  result = tablebaseResult(entryAt(table, tablebaseIndex(table.material, position, it->second.flipped)));
+  return true;
+}
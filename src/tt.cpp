@@ -0,0 +1,89 @@
+#include "tt.h"
+
+#include <algorithm>
+
+namespace {
+
+// data: move (16) | score (16) | depth (8) | bound (2) | generation (6).
+// A zero word never describes a stored entry since the bound is never
+// kNone, so an empty slot cannot match any key.
+constexpr std::uint64_t pack(Move move, int score, int depth, Bound bound, std::uint8_t generation) {
+  return move.raw() | (static_cast<std::uint64_t>(static_cast<std::uint16_t>(score)) << 16) |
+         (static_cast<std::uint64_t>(static_cast<std::uint8_t>(depth)) << 32) |
+         (static_cast<std::uint64_t>(bound) << 40) | (static_cast<std::uint64_t>(generation) << 42);
+}
+
+constexpr int depthOf(std::uint64_t data) { return static_cast<std::uint8_t>(data >> 32); }
+constexpr Bound boundOf(std::uint64_t data) { return static_cast<Bound>((data >> 40) & 3); }
+constexpr std::uint8_t generationOf(std::uint64_t data) { return (data >> 42) & 0x3F; }
+
+}  // namespace
+
+TranspositionTable::TranspositionTable(std::size_t megabytes) {
+  resize(megabytes);
+}
+
+void TranspositionTable::resize(std::size_t megabytes) {
+  bucketCount_ = std::max<std::size_t>(1, (megabytes << 20) / sizeof(Bucket));
+  buckets_ = std::make_unique<Bucket[]>(bucketCount_);
+  generation_.store(0, std::memory_order_relaxed);
+}
+
+void TranspositionTable::clear() {
+  for (std::size_t i = 0; i < bucketCount_; ++i) {
+    for (Slot& slot : buckets_[i].slots) {
+      slot.check.store(0, std::memory_order_relaxed);
+      slot.data.store(0, std::memory_order_relaxed);
+    }
+  }
+  generation_.store(0, std::memory_order_relaxed);
+}
+
+bool TranspositionTable::probe(Key key, TableEntry& entry) const {
+  const Bucket& bucket = buckets_[index(key)];
+  for (const Slot& slot : bucket.slots) {
+    const std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+    if ((slot.check.load(std::memory_order_relaxed) ^ data) != key || boundOf(data) == Bound::kNone)
+      continue;
+    entry.move = Move::fromRaw(static_cast<std::uint16_t>(data));
+    entry.score = static_cast<std::int16_t>(data >> 16);
+    entry.depth = depthOf(data);
+    entry.bound = boundOf(data);
+    return true;
+  }
+  return false;
+}
+
+void TranspositionTable::store(Key key, int depth, int score, Bound bound, Move move) {
+  Bucket& bucket = buckets_[index(key)];
+
+  // Age in searches, wrapping with the 6 bit generation counter.
+  const std::uint8_t generation = generation_.load(std::memory_order_relaxed);
+  auto age = [generation](std::uint64_t data) { return (generation - generationOf(data)) & kGenerationMask; };
+
+  Slot* victim = &bucket.slots[0];
+  int victimWorth = 1 << 30;
+  for (Slot& slot : bucket.slots) {
+    const std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+    if ((slot.check.load(std::memory_order_relaxed) ^ data) == key) {
+      // Same position: keep a deeper result from this search unless the
+      // new one is exact, but hold on to the best move we knew.
+      if (bound != Bound::kExact && age(data) == 0 && depthOf(data) > depth + 2)
+        return;
+      if (move.isNull())
+        move = Move::fromRaw(static_cast<std::uint16_t>(data));
+      victim = &slot;
+      break;
+    }
+    const int worth =
+        boundOf(data) == Bound::kNone ? -(1 << 30) : depthOf(data) - 8 * static_cast<int>(age(data));
+    if (worth < victimWorth) {
+      victim = &slot;
+      victimWorth = worth;
+    }
+  }
+
+  const std::uint64_t data = pack(move, score, depth, bound, generation);
+  victim->check.store(key ^ data, std::memory_order_relaxed);
+  victim->data.store(data, std::memory_order_relaxed);
+}